@@ -72,6 +72,14 @@ void app_main(void)
         S s2 = at24256.read<S>(0x10A).value(); // .value() because safe_mode returned an std::optional
         // S s2 = at24256.read<S>(0x10A); when safe_mode is off
 
+        // Or without the padding, by listing the members to store
+        using SLayout = AT24C256Layout<&S::a, &S::b, &S::c, &S::d, &S::s>;
+
+        at24256.write_packed<SLayout>(0x10A, s1); // SLayout::SIZE bytes, serialized straight into the page transfer buffer
+
+        S s3 = at24256.read_packed<SLayout>(0x10A).value();
+        ESP_LOGI("app_main", "Unpacked: a = %d, s = %s", s3.a, s3.s);
+
         // Write multiple bytes
         at24256.write(0x017D, std::vector<uint8_t>{0x10, 0x11, 0x12}); // Accepts any contiguous and sized std::ranges, like std::vector
 
@@ -1,35 +1,222 @@
 #pragma once
 
+#include <array>
+#include <bit>
 #include <cstddef>
 #include <optional>
 #include <ranges>
+#include <span>
 
 #include "driver/i2c_master.h"
 #include "esp_log.h"
 
+#include "AT24C256Layout.hpp"
+
+/**
+ * How write operations wait for the chip internal write cycle (tWR)
+ * 
+ * fixed_delay: sleep for write_delay_ms after each write
+ * ack_polling: probe the chip with address-only transfers until it acknowledges again
+ * deferred: return as soon as the data is transferred, the next operation
+ *           on the device ACK polls first if the write cycle is still running
+ */
+enum class AT24C256WriteCompletion
+{
+    fixed_delay,
+    ack_polling,
+    deferred
+};
+
+/**
+ * Per-device configuration, given to the AT24C256 constructor
+ */
+struct AT24C256Config
+{
+    // SCL clock of the device
+    // Up to 400 kHz at VCC >= 1.8 V, 1 MHz (Fast-mode Plus) at VCC >= 4.5 V
+    uint32_t scl_speed_hz = 100000;
+
+    AT24C256WriteCompletion write_completion = AT24C256WriteCompletion::ack_polling;
+
+    // ack_polling / deferred: maximum time to wait for the chip to acknowledge after a write
+    // The datasheet gives tWR = 5 ms max
+    uint32_t write_timeout_us = 10000;
+
+    // fixed_delay: time slept after each write
+    uint32_t write_delay_ms = 25;
+
+    // Multi-byte write(): read the affected pages first, and only program the
+    // bytes that differ (one write cycle per changed page, none for unchanged pages)
+    bool skip_unchanged = false;
+
+    // Attempts of each transfer, a transfer not acknowledged being retried after
+    // retry_backoff_us, doubled on each retry up to retry_backoff_max_us
+    uint8_t max_attempts = 3;
+    uint32_t retry_backoff_us = 200;
+    uint32_t retry_backoff_max_us = 5000;
+
+    // Timeout of each transfer, on top of its duration at scl_speed_hz
+    uint32_t xfer_timeout_ms = 20;
+
+    // Multi-byte write() and write_checked(): read the written data back and
+    // compare its CRC32 with the one of the source
+    bool verify_writes = false;
+
+    // Track the address counter of the chip, and skip the 2 word address bytes
+    // of reads starting where it points (receive-only transfer)
+    // Only valid if no other object or master accesses the chip
+    bool track_address = false;
+};
+
+// Build with -DAT24C256_STATS=1 to count the operations of each device (see AT24C256::stats())
+#ifndef AT24C256_STATS
+#define AT24C256_STATS 0
+#endif
+
+/**
+ * Operation counters and latency histograms of a device
+ * Only maintained when built with AT24C256_STATS
+ */
+struct AT24C256Stats
+{
+    // Upper bounds of the latency buckets, the last bucket holds anything longer
+    static constexpr std::array<uint32_t, 9> BUCKET_LIMITS_US{ 100, 200, 500, 1000, 2000, 5000, 10000, 20000, 50000 };
+    static constexpr size_t BUCKET_COUNT = BUCKET_LIMITS_US.size() + 1;
+
+    struct Histogram
+    {
+        std::array<uint32_t, BUCKET_COUNT> buckets{};
+        uint32_t count = 0;
+        uint32_t max_us = 0;
+        uint64_t total_us = 0;
+
+        void add(uint32_t us)
+        {
+            size_t bucket = 0;
+            while(bucket < BUCKET_LIMITS_US.size() && us >= BUCKET_LIMITS_US[bucket])
+                ++bucket;
+
+            buckets[bucket]++;
+            count++;
+            total_us += us;
+
+            if(us > max_us)
+                max_us = us;
+        }
+    };
+
+    uint64_t bytes_read = 0;
+    uint64_t bytes_written = 0;
+
+    // Internal write cycles started
+    uint32_t page_cycles = 0;
+
+    // Failed transfer attempts (not acknowledged or timed out), and attempts retried
+    uint32_t nacks = 0;
+    uint32_t retries = 0;
+
+    // ACK polls answered while the write cycle was still running, and total time waited for write cycles
+    uint32_t busy_polls = 0;
+    uint64_t busy_wait_us = 0;
+
+    // Whole operations, waiting for a previous write cycle included (a page at a time for writes)
+    Histogram read_latency;
+    Histogram write_latency;
+
+    // Write cycle waits
+    Histogram wait_latency;
+};
+
+/**
+ * Page geometry of an AT24Cxx chip
+ * Page math is done with shifts and masks, sizes being powers of two
+ */
+template<uint16_t page_size, uint16_t page_count>
+requires (std::has_single_bit(page_size) && std::has_single_bit(page_count) && page_size * page_count <= 0x10000)
+struct AT24CxxGeometry
+{
+    static constexpr int PAGE_SIZE = page_size;
+    static constexpr int PAGE_COUNT = page_count;
+    static constexpr int MEMORY_SIZE = PAGE_COUNT * PAGE_SIZE;
+
+    static constexpr int PAGE_SHIFT = std::countr_zero(page_size);
+    static constexpr uint16_t PAGE_MASK = PAGE_SIZE - 1;
+    static constexpr uint32_t ADDRESS_MASK = MEMORY_SIZE - 1;
+};
+
+// 64 Kbit, 32 bytes pages
+using AT24C64Geometry = AT24CxxGeometry<32, 256>;
+
+// 256 Kbit, 64 bytes pages
+using AT24C256Geometry = AT24CxxGeometry<64, 512>;
+
+// 512 Kbit, 128 bytes pages
+using AT24C512Geometry = AT24CxxGeometry<128, 512>;
+
 /**
  * An AT24C256 EEPROM chip from Atmel
  * capable of storing 262144 bits at 32768 distinct addresses
  * 
  * safe_mode: if enabled, performs additional checks and logs (bound checks, addresses checks, ...)
  * It is enable by default
+ * 
+ * Geometry: page size and count, for the other chips of the family
+ * sharing the same 2 bytes word address (see AT24C64 and AT24C512 below)
  */
-template<bool safe_mode = true>
+template<bool safe_mode = true, typename Geometry = AT24C256Geometry>
 class AT24C256
 {
 public:
     static constexpr int I2C_MASTER_FREQ_HZ = 100000;
+    static constexpr int I2C_MASTER_FREQ_HZ_FAST = 400000;
+    static constexpr int I2C_MASTER_FREQ_HZ_MAX = 1000000;
 
-    static constexpr int PAGE_COUNT = 512;
-    static constexpr int PAGE_SIZE = 64;
-    static constexpr int MEMORY_SIZE = PAGE_COUNT * PAGE_SIZE;
+    static constexpr int PAGE_COUNT = Geometry::PAGE_COUNT;
+    static constexpr int PAGE_SIZE = Geometry::PAGE_SIZE;
+    static constexpr int MEMORY_SIZE = Geometry::MEMORY_SIZE;
+
+    static constexpr int PAGE_SHIFT = Geometry::PAGE_SHIFT;
+    static constexpr uint16_t PAGE_MASK = Geometry::PAGE_MASK;
+    static constexpr uint32_t ADDRESS_MASK = Geometry::ADDRESS_MASK;
+
+    static constexpr size_t DEFAULT_READ_CHUNK_SIZE = 256;
 
-    // First address: 0x0000
-    // Last address:  0x7FFF
+    static constexpr int CHECKSUM_SIZE = 4;
+
+    // Unused bytes worth reading to save a transfer: about the cost of a new address
+    static constexpr uint16_t READV_MAX_GAP = 4;
+
+    // AT24C256: first address 0x0000, last address 0x7FFF
     // (0b111111111'111111, 9 + 6 = 15 bits)
 
+    /**
+     * Receives the chunks of read_stream()
+     * Return false to stop the stream
+     */
+    using ChunkConsumer = bool (*)(uint16_t address, const uint8_t* data, size_t size, void* user_data);
+
+    /**
+     * Receives the progress of fill(), erase() and program_image(), after each page
+     */
+    using ProgressCallback = void (*)(uint16_t done_pages, uint16_t total_pages, void* user_data);
+
+    /**
+     * A segment of writev() / readv(): data to write, or buffer to fill, at address
+     */
+    struct WriteSegment
+    {
+        uint16_t address;
+        std::span<const uint8_t> data;
+    };
+
+    struct ReadSegment
+    {
+        uint16_t address;
+        std::span<uint8_t> buffer;
+    };
+
 public:
-    AT24C256(i2c_master_bus_handle_t bus, uint8_t address);
+    AT24C256(i2c_master_bus_handle_t bus, uint8_t address, const AT24C256Config& config = {});
 
     AT24C256(const AT24C256 &other) = delete;
     AT24C256(AT24C256 &&other);
@@ -49,16 +236,21 @@ public:
     /**
      * Write a sequence of bytes anywhere on the chip
      * 
+     * With config.skip_unchanged, each page is read and compared first: only the span
+     * from its first to its last differing byte is programmed.
+     * If given, programmed receives the number of bytes actually programmed.
+     * 
      * Return true on success, false on faillure
      * On faillure, check logs for more info
      */
-    bool write(uint16_t address, uint8_t* buffer, uint16_t size) const;
+    bool write(uint16_t address, uint8_t* buffer, uint16_t size, uint16_t* programmed = nullptr) const;
 
     /**
-     * Write arbitrary data
+     * Write arbitrary trivially copyable data, as its raw bytes (padding included)
+     * See write_packed() for a layout without padding
      */
     template<typename T>
-    requires (!std::ranges::contiguous_range<T>) 
+    requires AT24C256Object<T>
     bool write(uint16_t address, const T& value) const
     {
         return write(address, (uint8_t*) &value, sizeof(T));
@@ -109,13 +301,66 @@ public:
      * Multi-byte write inside the same page.
      * The function can write as many bytes as there is between address
      * and the last page byte.
-     * A page being 64 bytes, this function can write at most 64 bytes at once. 
+     * A page being PAGE_SIZE bytes (64 on the AT24C256), this function can write at most PAGE_SIZE bytes at once. 
      * 
      * Return true on success, false on faillure
      * On faillure, check logs for more info
      */
     bool write_page(uint16_t address, uint8_t* buffer, uint16_t size) const;
 
+    /**
+     * write() and write_page() without the address and size checks, even in safe_mode,
+     * for callers that already validated their address math:
+     * [address, address+size) must be within the chip, and within one page for write_page_unchecked()
+     */
+    bool write_unchecked(uint16_t address, uint8_t* buffer, uint16_t size, uint16_t* programmed = nullptr) const;
+    bool write_page_unchecked(uint16_t address, uint8_t* buffer, uint16_t size) const;
+
+    /**
+     * Write several segments, in any order, with one write cycle per page touched.
+     * The segments of a page are merged into a single write_page(): bytes between
+     * them are read from the chip first. Where segments overlap, the last one wins.
+     * 
+     * Return true on success, false on faillure
+     * On faillure, some pages may have been written already
+     */
+    bool writev(std::span<const WriteSegment> segments) const;
+
+    /**
+     * Set every byte of the chip to value / to 0xFF, a whole page per write cycle
+     * skip_matching: read each page first, and skip it if it already holds the data
+     * Write cycles are ACK polled whatever config.write_completion
+     * 
+     * Return true on success, false on faillure
+     */
+    bool fill(uint8_t value, bool skip_matching = false, ProgressCallback progress = nullptr, void* user_data = nullptr) const;
+    bool erase(bool skip_matching = false, ProgressCallback progress = nullptr, void* user_data = nullptr) const;
+
+    /**
+     * Program image at address, a whole page per write cycle
+     * Same options as fill()
+     * 
+     * Return true on success, false on faillure
+     */
+    bool program_image(uint16_t address, std::span<const uint8_t> image, bool skip_matching = false, ProgressCallback progress = nullptr, void* user_data = nullptr) const;
+
+    /**
+     * Write a sequence of bytes followed by their CRC32 (CHECKSUM_SIZE bytes)
+     * 
+     * Return true on success, false on faillure
+     */
+    bool write_checked(uint16_t address, const uint8_t* buffer, uint16_t size) const;
+
+    /**
+     * Write arbitrary data followed by its CRC32
+     */
+    template<typename T>
+    requires AT24C256Object<T>
+    bool write_checked(uint16_t address, const T& value) const
+    {
+        return write_checked(address, (const uint8_t*) &value, sizeof(T));
+    }
+
     /**
      * Read a single byte at given address
      */
@@ -123,16 +368,93 @@ public:
 
     /**
      * Read a sequence of bytes
-     * If size is > than remaining bytes between address and last addressable byte,
-     * it loops back to address 0x0000
+     * In safe_mode, reading past the last addressable byte is an error.
+     * Otherwise, if size is > than remaining bytes between address and last
+     * addressable byte, it loops back to address 0x0000
      */
     bool read(uint16_t address, uint8_t* buffer, size_t size) const;
 
+    /**
+     * read() without the address and size checks, even in safe_mode
+     * Loops back to address 0x0000 past the last addressable byte
+     */
+    bool read_unchecked(uint16_t address, uint8_t* buffer, size_t size) const;
+
+    /**
+     * Current address read: size bytes from where the address counter of the
+     * chip points (the byte following the last one read), with a receive-only
+     * transfer. Loops back to address 0x0000 past the last addressable byte.
+     * 
+     * Return true on success, false on faillure
+     */
+    bool read_current(uint8_t* buffer, size_t size) const;
+
+    /**
+     * Where the address counter of the chip points, as tracked by the object:
+     * empty until a read, and after any write or failed transfer
+     */
+    std::optional<uint16_t> current_address() const { return _current_address; }
+
+    /**
+     * Read a sequence of bytes as several transfers of at most chunk_size bytes
+     * Never loops back to address 0x0000: in safe_mode, reading past the last
+     * address is an error
+     * Buffers located in PSRAM are filled through an internal RAM bounce buffer
+     * 
+     * Return true on success, false on faillure
+     */
+    bool read_chunked(uint16_t address, uint8_t* buffer, size_t size, size_t chunk_size = DEFAULT_READ_CHUNK_SIZE) const;
+
+    /**
+     * Read size bytes starting at address, chunk_size bytes at a time, and
+     * hand each chunk to consumer. The chunk buffer is allocated in internal RAM
+     * for the duration of the call.
+     * Same bounds as read_chunked()
+     * 
+     * Return false if a read failed. Stopping from the consumer is not a faillure.
+     */
+    bool read_stream(uint16_t address, size_t size, ChunkConsumer consumer, void* user_data = nullptr, size_t chunk_size = DEFAULT_READ_CHUNK_SIZE) const;
+
+    /**
+     * Fill several segments, in any order. Segments at most READV_MAX_GAP bytes
+     * apart are read by a single transfer while it stays within PAGE_SIZE bytes.
+     * Never loops back to address 0x0000
+     * 
+     * Return true on success, false on faillure
+     */
+    bool readv(std::span<const ReadSegment> segments) const;
+
+    /**
+     * Read a sequence of bytes written by write_checked(), and check their CRC32
+     * 
+     * Return false on faillure, or if the CRC32 does not match
+     */
+    bool read_checked(uint16_t address, uint8_t* buffer, uint16_t size) const;
+
+    /**
+     * Read arbitrary data written by write_checked(), and check its CRC32
+     * Unlike read<T>(), fails in both modes: value is left unspecified on faillure
+     */
+    template<typename T>
+    requires AT24C256Object<T>
+    bool read_checked(uint16_t address, T& value) const
+    {
+        return read_checked(address, (uint8_t*) &value, sizeof(T));
+    }
+
+    /**
+     * CRC32 (esp_rom_crc32_le()) of size bytes of the chip starting at address,
+     * read a page at a time through a stack buffer
+     * 
+     * Return true on success, false on faillure
+     */
+    bool crc32(uint16_t address, uint16_t size, uint32_t& crc) const;
+
     /**
      * Read arbitrary data
      */
     template<typename T>
-    requires (!std::ranges::contiguous_range<T>) 
+    requires AT24C256Object<T>
     auto read(uint16_t address) const -> typename std::conditional<safe_mode, std::optional<T>, T>::type
     {
         T value;
@@ -228,10 +550,171 @@ public:
         return read(address, (uint8_t*) std::ranges::data(range), std::ranges::size(range) * sizeof(std::ranges::range_value_t<R>));
     }
 
+    /**
+     * Write value in the packed layout Layout (see AT24C256Layout): each page
+     * is serialized straight into the transfer buffer, without padding
+     * config.skip_unchanged does not apply, config.verify_writes does
+     * 
+     * Return true on success, false on faillure
+     */
+    template<typename Layout>
+    bool write_packed(uint16_t address, const typename Layout::type& value) const
+    {
+        return write_serialized(address, Layout::SIZE, [](const void* object, size_t offset, uint8_t* out, size_t size) {
+            Layout::pack(*static_cast<const typename Layout::type*>(object), offset, out, size);
+        }, &value);
+    }
+
+    /**
+     * Read a value stored in the packed layout Layout (see AT24C256Layout)
+     */
+    template<typename Layout>
+    auto read_packed(uint16_t address) const -> typename std::conditional<safe_mode, std::optional<typename Layout::type>, typename Layout::type>::type
+    {
+        std::array<uint8_t, Layout::SIZE> packed;
+        typename Layout::type value{};
+
+        bool result = read(address, packed.data(), packed.size());
+
+        if constexpr (safe_mode) 
+        {
+            if(!result)
+                return std::nullopt;
+        }
 
+        Layout::unpack(packed.data(), value);
+
+        return value;
+    }
+
+    /**
+     * Wait for the write cycle started by the last write operation, if it is
+     * still running. Returns immediately otherwise.
+     * Only useful with AT24C256WriteCompletion::deferred, every other operation
+     * already calls it first.
+     * 
+     * Return false if the chip did not acknowledge before config.write_timeout_us
+     */
+    bool wait_ready() const;
+
+    /**
+     * Whether the write cycle started by the last write operation is still running
+     * Probes the chip at most once, never waits: lets a caller driving several
+     * chips in deferred mode move on to another one
+     */
+    bool busy() const;
+
+#if AT24C256_STATS
+    /**
+     * Counters and latency histograms since construction or the last reset_stats()
+     */
+    const AT24C256Stats& stats() const { return _stats; }
+
+    void reset_stats() { _stats = {}; }
+#endif
 
 private:
+    /**
+     * Wait for the end of the internal write cycle, config.write_completion
+     * being usually given
+     * 
+     * Return false if the chip did not acknowledge before config.write_timeout_us
+     */
+    bool wait_write_cycle(AT24C256WriteCompletion completion) const;
+
+    /**
+     * Transfer the word address and data of a single page write
+     * The caller waits for the previous write cycle, and marks the new one as pending
+     */
+    bool transmit_page(uint16_t address, const uint8_t* buffer, uint16_t size) const;
+
+    /**
+     * Receive size bytes at address, with the retry policy of the config
+     * skip_address: the chip points at address already, the first attempt
+     * does not send the word address
+     * Keeps track of the address counter of the chip
+     */
+    esp_err_t receive(uint16_t address, uint8_t* buffer, size_t size, bool skip_address) const;
+
+    /**
+     * Word address followed by the data of a page write
+     */
+    using Payload = std::array<uint8_t, 2+PAGE_SIZE>;
+
+    /**
+     * Same as transmit_page(), for size bytes already staged after the word address
+     */
+    bool transmit_payload(uint16_t address, Payload& payload, uint16_t size) const;
+
+    /**
+     * Serializes bytes [offset, offset+size) of object to out
+     */
+    using Serializer = void (*)(const void* object, size_t offset, uint8_t* out, size_t size);
+
+    /**
+     * Write size bytes produced by serialize, a page at a time, for write_packed()
+     */
+    bool write_serialized(uint16_t address, uint16_t size, Serializer serialize, const void* object) const;
+
+    /**
+     * Program size bytes from address a page at a time, for fill() and program_image()
+     * repeat: data is a single page, programmed in every page
+     */
+    bool program(uint16_t address, const uint8_t* data, size_t size, bool repeat, bool skip_matching, ProgressCallback progress, void* user_data) const;
+
+    /**
+     * Called after each successful write transfer: mark the write cycle
+     * as pending, and wait for it unless completion is deferred
+     */
+    bool end_write() const;
+
+    /**
+     * Statistics hooks, empty unless built with AT24C256_STATS
+     * stats_start() gives the start time of an operation
+     */
+    int64_t stats_start() const;
+    void stats_read(size_t size, int64_t start) const;
+    void stats_write(size_t size, int64_t start) const;
+    void stats_wait(uint32_t busy_polls, int64_t start) const;
+    void stats_nack() const;
+    void stats_retry() const;
+
+    /**
+     * Run transfer(timeout_ms) with the retry policy of the config
+     * size: number of bytes transferred, to compute the timeout
+     */
+    template<typename Transfer>
+    esp_err_t with_retries(size_t size, Transfer&& transfer) const;
+
+    /**
+     * Timeout of a transfer of size bytes, config.xfer_timeout_ms included
+     */
+    int transfer_timeout_ms(size_t size) const;
+
+    static constexpr int ACK_POLL_XFER_TIMEOUT_MS = 10;
+
+    // Retry backoffs up to this long spin, well below the 5 ms write cycle
+    static constexpr uint32_t MAX_BACKOFF_SPIN_US = 500;
+
     uint8_t _address;
+    AT24C256Config _config;
+    i2c_master_bus_handle_t _bus;
     i2c_device_config_t  _dev_cfg;
     i2c_master_dev_handle_t _dev_handle;
-};
\ No newline at end of file
+
+    // A write cycle may still be running on the chip
+    mutable bool _write_pending = false;
+
+    // Address counter of the chip, when known
+    mutable std::optional<uint16_t> _current_address;
+
+#if AT24C256_STATS
+    mutable AT24C256Stats _stats;
+#endif
+};
+
+template<bool safe_mode = true>
+using AT24C64 = AT24C256<safe_mode, AT24C64Geometry>;
+
+template<bool safe_mode = true>
+using AT24C512 = AT24C256<safe_mode, AT24C512Geometry>;
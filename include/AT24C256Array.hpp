@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "AT24C256.hpp"
+
+/**
+ * Up to 8 AT24C256 chips sharing a bus (addresses 0x50 to 0x57),
+ * seen as a single device with a flat address space
+ * 
+ * Linear mode: chip 0 holds addresses 0 to 0x7FFF, chip 1 the following 32 KB, ...
+ * Striped mode: consecutive pages are spread across chips (page p is on chip p % N),
+ * so that large sequential writes keep every chip busy: while a chip runs its
+ * write cycle, the next pages are sent to the others.
+ * 
+ * In unsafe mode, addresses past size() wrap around the array.
+ */
+template<bool safe_mode = true>
+class AT24C256Array
+{
+public:
+    static constexpr int PAGE_SIZE = AT24C256<safe_mode>::PAGE_SIZE;
+    static constexpr int CHIP_SIZE = AT24C256<safe_mode>::MEMORY_SIZE;
+    static constexpr size_t MAX_CHIPS = 8;
+
+public:
+    /**
+     * Register a chip for each of the given addresses, all with the same config
+     * 1 to MAX_CHIPS addresses, aborts otherwise
+     * 
+     * Writes complete as requested by config.write_completion, but chips are
+     * driven in deferred mode internally so that their write cycles overlap
+     */
+    AT24C256Array(i2c_master_bus_handle_t bus, std::span<const uint8_t> addresses, bool striped = false, const AT24C256Config& config = {});
+
+    AT24C256Array(const AT24C256Array &other) = delete;
+    AT24C256Array& operator=(const AT24C256Array &other) = delete;
+
+    /**
+     * Total size in bytes
+     */
+    uint32_t size() const { return _chips.size() * CHIP_SIZE; }
+
+    size_t chip_count() const { return _chips.size(); }
+
+    const AT24C256<safe_mode>& chip(size_t index) const { return _chips[index]; }
+
+    /**
+     * Write a sequence of bytes anywhere in the address space
+     * config.skip_unchanged and config.verify_writes apply, but both wait for
+     * the write cycle of the chip first: pages are then no longer pipelined
+     * 
+     * Return true on success, false on faillure
+     * On faillure, check logs for more info
+     */
+    bool write(uint32_t address, const uint8_t* buffer, size_t size) const;
+
+    /**
+     * Write arbitrary data
+     */
+    template<typename T>
+    requires AT24C256Object<T>
+    bool write(uint32_t address, const T& value) const
+    {
+        return write(address, (const uint8_t*) &value, sizeof(T));
+    }
+
+    /**
+     * Read a sequence of bytes anywhere in the address space
+     * 
+     * Return true on success, false on faillure
+     */
+    bool read(uint32_t address, uint8_t* buffer, size_t size) const;
+
+    /**
+     * Read arbitrary data
+     */
+    template<typename T>
+    requires AT24C256Object<T>
+    auto read(uint32_t address) const -> typename std::conditional<safe_mode, std::optional<T>, T>::type
+    {
+        T value;
+
+        bool result = read(address, (uint8_t*) &value, sizeof(T));
+
+        if constexpr (safe_mode) 
+        {
+            if(!result)
+                return std::nullopt;
+        }
+
+        return value;
+    }
+
+    /**
+     * Wait for the write cycles still running on every chip
+     */
+    bool wait_ready() const;
+
+private:
+    /**
+     * Contiguous run of bytes on a single chip
+     */
+    struct Location
+    {
+        size_t chip;
+        uint16_t address;
+        uint16_t size;
+    };
+
+    /**
+     * Where the first bytes of [address, address+size[ are
+     */
+    Location locate(uint32_t address, size_t size) const;
+
+    bool check_range(const char* tag, uint32_t address, size_t size) const;
+
+    std::vector<AT24C256<safe_mode>> _chips;
+    bool _striped;
+    AT24C256WriteCompletion _write_completion;
+};
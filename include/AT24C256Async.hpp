@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "AT24C256.hpp"
+
+/**
+ * Non-blocking access to an AT24C256, through a dedicated worker task
+ * 
+ * Operations are queued and executed in order by the worker, the calling
+ * task only pays for the queueing. Completion is reported through an
+ * optional callback, called from the worker task.
+ * 
+ * With the device configured with AT24C256WriteCompletion::deferred, the
+ * worker moves on as soon as a page is transferred: the next page (or the
+ * next queued operation) is sent the moment the chip ACKs the previous one.
+ * 
+ * The device must not be used directly while operations are queued.
+ */
+template<bool safe_mode = true>
+class AT24C256Async
+{
+public:
+    /**
+     * Called from the worker task once an operation is done
+     */
+    using Callback = void (*)(bool success, void* user_data);
+
+    static constexpr size_t DEFAULT_QUEUE_DEPTH = 8;
+    static constexpr UBaseType_t DEFAULT_PRIORITY = 5;
+    static constexpr uint32_t DEFAULT_STACK_SIZE = 4096;
+
+public:
+    /**
+     * eeprom must outlive the object
+     * queue_depth is the amount of operations that can be pending at once
+     */
+    AT24C256Async(const AT24C256<safe_mode>& eeprom, 
+        size_t queue_depth = DEFAULT_QUEUE_DEPTH, 
+        UBaseType_t priority = DEFAULT_PRIORITY, 
+        uint32_t stack_size = DEFAULT_STACK_SIZE);
+
+    AT24C256Async(const AT24C256Async &other) = delete;
+    AT24C256Async& operator=(const AT24C256Async &other) = delete;
+
+    /**
+     * Execute the operations still queued, then stop the worker
+     */
+    ~AT24C256Async();
+
+    /**
+     * Queue a write of data at address
+     * data must stay valid until the callback is called
+     * 
+     * Return false if the queue is full, or if data is larger than the chip
+     */
+    bool write_async(uint16_t address, std::span<const uint8_t> data, Callback callback = nullptr, void* user_data = nullptr);
+
+    /**
+     * Queue a read of buffer.size() bytes at address into buffer
+     * buffer must stay valid until the callback is called
+     * 
+     * Return false if the queue is full, or if buffer is larger than the chip
+     */
+    bool read_async(uint16_t address, std::span<uint8_t> buffer, Callback callback = nullptr, void* user_data = nullptr);
+
+    /**
+     * Read size bytes starting at address, chunk_size bytes at a time, and hand
+     * each chunk to consumer, from the calling task. Double-buffered: the worker
+     * reads the next chunk while the consumer processes the current one.
+     * Blocks until the stream is done, must not be called from a callback.
+     * 
+     * Return false if a read failed. Stopping from the consumer is not a faillure.
+     */
+    bool read_stream(uint16_t address, size_t size, typename AT24C256<safe_mode>::ChunkConsumer consumer, void* user_data = nullptr, 
+        size_t chunk_size = AT24C256<safe_mode>::DEFAULT_READ_CHUNK_SIZE);
+
+    /**
+     * Block until every operation queued before the call is done
+     * Should be called from a single task at a time
+     * 
+     * Return false on timeout
+     */
+    bool wait_idle(TickType_t timeout = portMAX_DELAY);
+
+private:
+    enum class Operation : uint8_t
+    {
+        write,
+        read,
+        barrier,
+        stop
+    };
+
+    struct Request
+    {
+        Operation operation;
+        uint16_t address = 0;
+        uint8_t* buffer = nullptr;
+        size_t size = 0;
+        Callback callback = nullptr;
+        void* user_data = nullptr;
+    };
+
+    bool enqueue(const Request& request, TickType_t timeout);
+
+    static void worker(void* arg);
+
+    const AT24C256<safe_mode>& _eeprom;
+    QueueHandle_t _queue;
+    SemaphoreHandle_t _idle;
+    SemaphoreHandle_t _stopped;
+};
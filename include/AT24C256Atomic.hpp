@@ -0,0 +1,154 @@
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <cstddef>
+
+#include "AT24C256.hpp"
+
+/**
+ * Region of pages updated by atomic transactions: after a power loss, either
+ * all the writes of a transaction are visible, or none of them.
+ * 
+ * Each logical page has two physical copies. write() stages data in the copy
+ * that is not current, commit() then makes the staged copies current by writing
+ * a commit record (sequence number, current copy of each page, CRC32): one
+ * extra page write per transaction, whatever its size.
+ * 
+ * The header page holds two commit record slots, written in turn. A page write
+ * only programs the bytes it carries, so a torn commit leaves the other slot,
+ * the previous state, intact. mount() reads the header page only.
+ */
+template<bool safe_mode = true>
+class AT24C256Atomic
+{
+public:
+    static constexpr int PAGE_SIZE = AT24C256<safe_mode>::PAGE_SIZE;
+    static constexpr int PAGE_COUNT = AT24C256<safe_mode>::PAGE_COUNT;
+
+    static constexpr int SLOT_SIZE = PAGE_SIZE / 2;
+
+    // One bit per logical page in a commit record
+    static constexpr uint16_t MAX_PAGES = (SLOT_SIZE - 8) * 8;
+
+public:
+    /**
+     * The region holds page_count logical pages (at most MAX_PAGES), using
+     * pages first_page to first_page + 2 * page_count (header page included)
+     * eeprom must outlive the region
+     */
+    AT24C256Atomic(const AT24C256<safe_mode>& eeprom, uint16_t first_page, uint16_t page_count);
+
+    AT24C256Atomic(const AT24C256Atomic &other) = delete;
+    AT24C256Atomic& operator=(const AT24C256Atomic &other) = delete;
+
+    /**
+     * Read the last commit record, must be called before any other operation
+     * An unused region starts with the first copy of every page current
+     * 
+     * Return false on bus faillure
+     */
+    bool mount();
+
+    /**
+     * Size of the region in bytes, addresses are relative to its start
+     */
+    uint16_t size() const { return _page_count * PAGE_SIZE; }
+
+    /**
+     * Stage a write in the current transaction. Not visible after a power loss
+     * until commit() returns, visible to read() immediately.
+     * The first write to a page copies the rest of the page to its staged copy,
+     * so write whole structures at once rather than field by field.
+     * 
+     * Return true on success, false on faillure
+     */
+    bool write(uint16_t address, const uint8_t* buffer, uint16_t size);
+
+    template<typename T>
+    requires AT24C256Object<T>
+    bool write(uint16_t address, const T& value)
+    {
+        return write(address, (const uint8_t*) &value, sizeof(T));
+    }
+
+    /**
+     * Read committed data, or staged data for pages written in the current transaction
+     * 
+     * Return true on success, false on faillure
+     */
+    bool read(uint16_t address, uint8_t* buffer, uint16_t size) const;
+
+    template<typename T>
+    requires AT24C256Object<T>
+    auto read(uint16_t address) const -> typename std::conditional<safe_mode, std::optional<T>, T>::type
+    {
+        T value;
+
+        bool result = read(address, (uint8_t*) &value, sizeof(T));
+
+        if constexpr (safe_mode) 
+        {
+            if(!result)
+                return std::nullopt;
+        }
+
+        return value;
+    }
+
+    /**
+     * Make the writes of the current transaction durable, all at once
+     * 
+     * Return false on faillure: the transaction is still pending, commit() can be retried
+     */
+    bool commit();
+
+    /**
+     * Drop the writes of the current transaction
+     */
+    void rollback() { _staged.reset(); }
+
+    /**
+     * Whether the current transaction has writes
+     */
+    bool pending() const { return _staged.any(); }
+
+    /**
+     * Sequence number of the last commit
+     */
+    uint32_t sequence() const { return _sequence; }
+
+private:
+    struct [[gnu::packed]] CommitRecord
+    {
+        uint32_t sequence;
+        std::array<uint8_t, MAX_PAGES / 8> copies;
+        uint32_t crc;
+    };
+
+    static_assert(sizeof(CommitRecord) == SLOT_SIZE);
+
+    static uint32_t crc(const CommitRecord& record);
+
+    bool check_range(const char* tag, uint16_t address, uint16_t size) const;
+
+    /**
+     * Physical address of a copy of a logical page
+     */
+    uint16_t address(uint16_t page, bool copy) const { return (_first_page + 1 + 2 * page + copy) * PAGE_SIZE; }
+
+    /**
+     * Copy of a logical page read() sees: the staged one if written in the current transaction
+     */
+    bool visible_copy(uint16_t page) const { return _current[page] ^ _staged[page]; }
+
+    const AT24C256<safe_mode>& _eeprom;
+    uint16_t _first_page;
+    uint16_t _page_count;
+
+    bool _mounted = false;
+
+    uint32_t _sequence = 0;
+    std::bitset<MAX_PAGES> _current;
+    std::bitset<MAX_PAGES> _staged;
+};
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <span>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "AT24C256.hpp"
+
+/**
+ * Scheduler for several AT24C256 sharing a bus, through a single task
+ * 
+ * Instead of each device sleeping through its own write cycles, the task
+ * sends a page to a chip, then serves the other chips while it programs it:
+ * queued reads first (a read only needs its chip to be idle), then the next
+ * page of the writes. It only waits when every chip with work is busy.
+ * 
+ * Operations on a device run in the order they were queued, operations on
+ * different devices in any order. Devices should be configured with
+ * AT24C256WriteCompletion::deferred, otherwise each write page blocks the
+ * task for the whole write cycle.
+ * 
+ * The devices must not be used directly while operations are queued.
+ */
+template<bool safe_mode = true>
+class AT24C256Bus
+{
+public:
+    /**
+     * Called from the scheduler task once an operation is done
+     */
+    using Callback = void (*)(bool success, void* user_data);
+
+    static constexpr size_t MAX_DEVICES = 8;
+
+    // Operations the task schedules among, beyond those waiting in the queue
+    static constexpr size_t MAX_PENDING = 16;
+
+    static constexpr size_t DEFAULT_QUEUE_DEPTH = 16;
+    static constexpr UBaseType_t DEFAULT_PRIORITY = 5;
+    static constexpr uint32_t DEFAULT_STACK_SIZE = 4096;
+
+public:
+    AT24C256Bus(size_t queue_depth = DEFAULT_QUEUE_DEPTH, 
+        UBaseType_t priority = DEFAULT_PRIORITY, 
+        uint32_t stack_size = DEFAULT_STACK_SIZE);
+
+    AT24C256Bus(const AT24C256Bus &other) = delete;
+    AT24C256Bus& operator=(const AT24C256Bus &other) = delete;
+
+    /**
+     * Execute the operations still queued, then stop the task
+     */
+    ~AT24C256Bus();
+
+    /**
+     * Register a device, which must outlive the scheduler
+     * Devices are registered before queuing operations on them
+     * 
+     * Return the index of the device, empty if MAX_DEVICES are registered already
+     */
+    std::optional<size_t> attach(const AT24C256<safe_mode>& eeprom);
+
+    /**
+     * Queue a write of data at address on device
+     * data must stay valid until the callback is called
+     * 
+     * Return false if the queue is full
+     */
+    bool write_async(size_t device, uint16_t address, std::span<const uint8_t> data, Callback callback = nullptr, void* user_data = nullptr);
+
+    /**
+     * Queue a read of buffer.size() bytes at address on device into buffer
+     * buffer must stay valid until the callback is called
+     * 
+     * Return false if the queue is full
+     */
+    bool read_async(size_t device, uint16_t address, std::span<uint8_t> buffer, Callback callback = nullptr, void* user_data = nullptr);
+
+    /**
+     * Wait until every operation queued before the call is done,
+     * and every write cycle is over
+     * 
+     * Return false on timeout
+     */
+    bool wait_idle(TickType_t timeout = portMAX_DELAY);
+
+private:
+    enum class Operation : uint8_t
+    {
+        write,
+        read,
+        barrier,
+        stop
+    };
+
+    struct Request
+    {
+        Operation operation;
+        uint8_t device = 0;
+        uint16_t address = 0;
+        uint8_t* buffer = nullptr;
+        size_t size = 0;
+        Callback callback = nullptr;
+        void* user_data = nullptr;
+
+        // Bytes written so far
+        size_t done = 0;
+    };
+
+    bool enqueue(const Request& request, TickType_t timeout);
+
+    bool check(const char* tag, size_t device, uint16_t address, size_t size) const;
+
+    /**
+     * Make progress on the pending operations without waiting for a write cycle
+     * 
+     * Return false if every chip with work is busy
+     */
+    bool schedule();
+
+    /**
+     * Send the next page of a write
+     * 
+     * Return true once the whole write is sent (or failed)
+     */
+    bool write_page(Request& request, bool& success);
+
+    void complete(size_t index, bool success);
+
+    static void task(void* arg);
+
+    std::array<const AT24C256<safe_mode>*, MAX_DEVICES> _devices{};
+    size_t _device_count = 0;
+
+    // Only used by the task, in queuing order
+    std::array<Request, MAX_PENDING> _pending;
+    size_t _pending_count = 0;
+
+    QueueHandle_t _queue;
+    SemaphoreHandle_t _idle;
+    SemaphoreHandle_t _stopped;
+};
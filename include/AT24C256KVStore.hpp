@@ -0,0 +1,238 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <optional>
+
+#include "AT24C256.hpp"
+
+/**
+ * Log-structured key/value store, spread over a range of pages
+ * 
+ * Keys are small integers (0 to 255), values are up to MAX_VALUE_SIZE bytes.
+ * Updates are appended to the page being filled (in RAM), which is written
+ * when full or on flush(): pages are written in turn across the whole range,
+ * so that every page wears at the same rate.
+ * 
+ * The location of each value is kept in a RAM index, built once by mount():
+ * get() costs a single bus read. Room is made by compaction: the live values
+ * of the oldest pages are moved to the newest one, which frees them.
+ * put() compacts on demand, compact() can be called ahead of time (from an
+ * idle loop for instance) to keep put() fast.
+ * 
+ * Page header: sequence number, amount of live pages up to this one,
+ * used size and CRC16. Records: key, size, value.
+ */
+template<bool safe_mode = true>
+class AT24C256KVStore
+{
+public:
+    static constexpr int PAGE_SIZE = AT24C256<safe_mode>::PAGE_SIZE;
+    static constexpr int PAGE_COUNT = AT24C256<safe_mode>::PAGE_COUNT;
+
+    static constexpr int HEADER_SIZE = 10;
+    static constexpr int PAYLOAD_SIZE = PAGE_SIZE - HEADER_SIZE;
+    static constexpr int RECORD_HEADER_SIZE = 2;
+    static constexpr int MAX_VALUE_SIZE = PAYLOAD_SIZE - RECORD_HEADER_SIZE;
+
+    static constexpr int KEY_COUNT = 256;
+    static constexpr uint16_t MIN_PAGE_COUNT = 4;
+
+public:
+    /**
+     * The store uses pages first_page to first_page + page_count - 1 (at least MIN_PAGE_COUNT)
+     * eeprom must outlive the store
+     */
+    AT24C256KVStore(const AT24C256<safe_mode>& eeprom, uint16_t first_page = 0, uint16_t page_count = PAGE_COUNT);
+
+    AT24C256KVStore(const AT24C256KVStore &other) = delete;
+    AT24C256KVStore& operator=(const AT24C256KVStore &other) = delete;
+
+    /**
+     * Flush the updates still in RAM
+     */
+    ~AT24C256KVStore();
+
+    /**
+     * Erase every page of the range (one write cycle per page), leaving
+     * an empty, mounted store. Only needed if the range holds leftovers of
+     * another store or log.
+     * 
+     * Return false on bus faillure
+     */
+    bool format();
+
+    /**
+     * Read the live pages and build the index, must be called before any other operation
+     * The newest page is found with a binary search, an unused or torn page
+     * counting as older. An unused range is an empty store. If page 0 is
+     * unused, torn or corrupted, every page is read instead.
+     * 
+     * Return false on bus faillure, or if a live page is corrupted (its
+     * updates can't be replayed, format() starts over)
+     */
+    bool mount();
+
+    /**
+     * Set the value of key (at most MAX_VALUE_SIZE bytes)
+     * Compacts first if less than 2 pages are free
+     * 
+     * Return false on faillure, or if the store is full
+     */
+    bool put(uint8_t key, const uint8_t* data, size_t size);
+
+    /**
+     * Set the value of key from arbitrary data
+     */
+    template<typename T>
+    requires AT24C256Object<T> && (sizeof(T) <= MAX_VALUE_SIZE)
+    bool put(uint8_t key, const T& value)
+    {
+        return put(key, (const uint8_t*) &value, sizeof(T));
+    }
+
+    /**
+     * Read the value of key into buffer, size must be the size of the value
+     * 
+     * Return false if the key does not exist, on size mismatch or on bus faillure
+     */
+    bool get(uint8_t key, uint8_t* buffer, size_t size) const;
+
+    /**
+     * Read the value of key as arbitrary data
+     */
+    template<typename T>
+    requires AT24C256Object<T>
+    auto get(uint8_t key) const -> typename std::conditional<safe_mode, std::optional<T>, T>::type
+    {
+        T value;
+
+        bool result = get(key, (uint8_t*) &value, sizeof(T));
+
+        if constexpr (safe_mode) 
+        {
+            if(!result)
+                return std::nullopt;
+        }
+
+        return value;
+    }
+
+    bool contains(uint8_t key) const { return _index[key].page != NONE; }
+
+    /**
+     * Size of the value of key, 0 if it does not exist
+     */
+    size_t value_size(uint8_t key) const { return contains(key) ? _index[key].size : 0; }
+
+    /**
+     * Remove key
+     * 
+     * Return false on faillure, or if the store is full
+     */
+    bool remove(uint8_t key);
+
+    /**
+     * Write the updates still in RAM. The following updates start a new page.
+     * 
+     * Return false on faillure
+     */
+    bool flush();
+
+    /**
+     * Compact the oldest pages until at least min_free_pages are free, or until
+     * every page was compacted once
+     * 
+     * Return false on bus faillure, or if min_free_pages could not be reached
+     */
+    bool compact(uint16_t min_free_pages);
+
+    /**
+     * Amount of pages that can be written before compaction is needed
+     */
+    uint16_t free_pages() const { return _page_count - 1 - used_pages(); }
+
+private:
+    static constexpr uint16_t NONE = 0xFFFF;
+    static constexpr uint8_t TOMBSTONE = 0xFF;
+
+    static_assert(MAX_VALUE_SIZE < TOMBSTONE);
+
+    struct [[gnu::packed]] Header
+    {
+        uint32_t sequence;
+        uint16_t live_pages;
+        uint8_t used;
+        uint8_t reserved;
+        uint16_t crc;
+    };
+
+    struct [[gnu::packed]] Page
+    {
+        Header header;
+        std::array<uint8_t, PAYLOAD_SIZE> payload;
+    };
+
+    static_assert(sizeof(Header) == HEADER_SIZE);
+    static_assert(sizeof(Page) == PAGE_SIZE);
+
+    struct Location
+    {
+        uint16_t page = NONE;
+        uint8_t offset = 0;
+        uint8_t size = 0;
+    };
+
+    enum class PageStatus : uint8_t
+    {
+        valid,
+        invalid,        // Unused, torn or corrupted
+        bus_error,
+    };
+
+    /**
+     * Read a page of the range, and check its CRC
+     */
+    PageStatus read_page(uint16_t index, Page& page) const;
+
+    /**
+     * Newest valid page by scanning the whole range, for when page 0 is invalid
+     * Return false on bus faillure, newest is empty if there is no valid page
+     */
+    bool scan(std::optional<uint16_t>& newest, Header& header) const;
+
+    static uint16_t crc(const Page& page);
+
+    /**
+     * Append a record to the page being filled, writing it first if it is full
+     */
+    bool append(uint8_t key, const uint8_t* data, uint8_t size);
+
+    /**
+     * Write the page being filled and move to the next one
+     */
+    bool write_tail();
+
+    /**
+     * Move the live records of the oldest page to the page being filled, and free it
+     */
+    bool compact_oldest();
+
+    uint16_t used_pages() const { return (_tail_index + _page_count - _oldest) % _page_count; }
+
+    uint16_t address(uint16_t index) const { return (_first_page + index) * PAGE_SIZE; }
+
+    const AT24C256<safe_mode>& _eeprom;
+    uint16_t _first_page;
+    uint16_t _page_count;
+
+    bool _mounted = false;
+
+    std::array<Location, KEY_COUNT> _index;
+
+    // Page being filled, in RAM, and its index in the range
+    // Pages _oldest to _tail_index - 1 hold live data, the others are free
+    Page _tail;
+    uint16_t _tail_index = 0;
+    uint16_t _oldest = 0;
+};
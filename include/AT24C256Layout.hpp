@@ -0,0 +1,97 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ranges>
+#include <type_traits>
+
+/**
+ * Objects that can be written / read as their raw bytes, padding included
+ */
+template<typename T>
+concept AT24C256Object = std::is_trivially_copyable_v<T> && !std::ranges::contiguous_range<T>;
+
+namespace AT24C256Detail
+{
+    template<typename M>
+    struct MemberPointer;
+
+    template<typename C, typename M>
+    struct MemberPointer<M C::*>
+    {
+        using owner = C;
+        using member = M;
+    };
+
+    template<auto First, auto... Others>
+    struct Owner
+    {
+        using type = typename MemberPointer<decltype(First)>::owner;
+    };
+}
+
+/**
+ * Packed layout of a struct, described by a list of pointers to its members:
+ * the fields are stored one after the other, in the given order,
+ * without any padding, in the native byte order
+ * 
+ * struct S { int a; double b; bool d; };
+ * using SLayout = AT24C256Layout<&S::a, &S::b, &S::d>;  // SIZE: 13 bytes instead of sizeof(S) = 24
+ * 
+ * Members left out of the layout are not stored, and are value initialized on read
+ */
+template<auto... Members>
+requires (sizeof...(Members) > 0)
+struct AT24C256Layout
+{
+    using type = typename AT24C256Detail::Owner<Members...>::type;
+
+    static_assert((std::is_same_v<typename AT24C256Detail::MemberPointer<decltype(Members)>::owner, type> && ...), 
+        "Every member must belong to the same struct");
+    static_assert((std::is_trivially_copyable_v<typename AT24C256Detail::MemberPointer<decltype(Members)>::member> && ...), 
+        "Every member must be trivially copyable");
+
+    static constexpr size_t SIZE = (sizeof(typename AT24C256Detail::MemberPointer<decltype(Members)>::member) + ...);
+
+    /**
+     * Serialize bytes [offset, offset+size) of the packed representation of value to out
+     * Lets a caller serialize a page at a time, straight into its transfer buffer
+     */
+    static void pack(const type& value, size_t offset, uint8_t* out, size_t size)
+    {
+        size_t field_offset = 0;
+
+        (copy_field(reinterpret_cast<const uint8_t*>(&(value.*Members)), sizeof(value.*Members), field_offset, offset, size, 
+            [&](const uint8_t* field, size_t position, size_t count) { std::memcpy(out + position, field, count); }), ...);
+    }
+
+    /**
+     * Deserialize SIZE bytes of packed representation from in
+     */
+    static void unpack(const uint8_t* in, type& value)
+    {
+        size_t field_offset = 0;
+
+        (copy_field(reinterpret_cast<uint8_t*>(&(value.*Members)), sizeof(value.*Members), field_offset, 0, SIZE, 
+            [&](uint8_t* field, size_t position, size_t count) { std::memcpy(field, in + position, count); }), ...);
+    }
+
+private:
+    /**
+     * Hand the part of a field overlapping [offset, offset+size) to copy,
+     * with its position relative to offset
+     */
+    template<typename Byte, typename Copy>
+    static void copy_field(Byte* field, size_t field_size, size_t& field_offset, size_t offset, size_t size, Copy&& copy)
+    {
+        size_t first = std::max(field_offset, offset);
+        size_t last = std::min(field_offset + field_size, offset + size);
+
+        if(first < last)
+            copy(field + (first - field_offset), first - offset, last - first);
+
+        field_offset += field_size;
+    }
+};
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <optional>
+
+#include "AT24C256.hpp"
+
+/**
+ * Append-only ring buffer of records, spread over a range of pages
+ * 
+ * Records are batched in RAM and written a whole page at a time, and pages
+ * are written in turn across the whole range (oldest pages being overwritten
+ * once it is full), so that every page wears at the same rate.
+ * 
+ * Each page holds a header (sequence number, used size, CRC16) followed by
+ * records, each record being its size (1 byte) followed by its data.
+ * Sequence numbers increase by one for each page written, which lets mount()
+ * find the newest page with a binary search (about 9 page reads for 512 pages).
+ */
+template<bool safe_mode = true>
+class AT24C256Log
+{
+public:
+    static constexpr int PAGE_SIZE = AT24C256<safe_mode>::PAGE_SIZE;
+    static constexpr int PAGE_COUNT = AT24C256<safe_mode>::PAGE_COUNT;
+
+    static constexpr int HEADER_SIZE = 8;
+    static constexpr int PAYLOAD_SIZE = PAGE_SIZE - HEADER_SIZE;
+    static constexpr int MAX_RECORD_SIZE = PAYLOAD_SIZE - 1;
+
+    /**
+     * Receives the records of for_each(), oldest first
+     * Return false to stop the iteration
+     */
+    using RecordConsumer = bool (*)(const uint8_t* data, size_t size, void* user_data);
+
+public:
+    /**
+     * The log uses pages first_page to first_page + page_count - 1 (at least 2)
+     * eeprom must outlive the log
+     */
+    AT24C256Log(const AT24C256<safe_mode>& eeprom, uint16_t first_page = 0, uint16_t page_count = PAGE_COUNT);
+
+    AT24C256Log(const AT24C256Log &other) = delete;
+    AT24C256Log& operator=(const AT24C256Log &other) = delete;
+
+    /**
+     * Flush the records still in RAM
+     */
+    ~AT24C256Log();
+
+    /**
+     * Find the newest page, must be called before any other operation
+     * An unused range starts as an empty log. If page 0 is torn or corrupted,
+     * every page is scanned instead.
+     * 
+     * Return false on bus faillure
+     */
+    bool mount();
+
+    /**
+     * Append a record of at most MAX_RECORD_SIZE bytes
+     * The record is written when its page is full, or on flush()
+     * 
+     * Return true on success, false on faillure
+     */
+    bool append(const uint8_t* data, size_t size);
+
+    /**
+     * Append arbitrary data as a record
+     */
+    template<typename T>
+    requires AT24C256Object<T> && (sizeof(T) <= MAX_RECORD_SIZE)
+    bool append(const T& record)
+    {
+        return append((const uint8_t*) &record, sizeof(T));
+    }
+
+    /**
+     * Write the records still in RAM. The following records start a new page,
+     * flushed records are never rewritten.
+     * 
+     * Return true on success, false on faillure
+     */
+    bool flush();
+
+    /**
+     * Call consumer on every record, oldest first, including
+     * the ones not flushed yet
+     * 
+     * Return false on bus faillure
+     */
+    bool for_each(RecordConsumer consumer, void* user_data = nullptr) const;
+
+    /**
+     * Sequence number of the page being filled
+     */
+    uint32_t sequence() const { return _tail.header.sequence; }
+
+private:
+    struct [[gnu::packed]] Header
+    {
+        uint32_t sequence;
+        uint8_t used;
+        uint8_t reserved;
+        uint16_t crc;
+    };
+
+    struct [[gnu::packed]] Page
+    {
+        Header header;
+        std::array<uint8_t, PAYLOAD_SIZE> payload;
+    };
+
+    static_assert(sizeof(Header) == HEADER_SIZE);
+    static_assert(sizeof(Page) == PAGE_SIZE);
+
+    enum class PageStatus : uint8_t
+    {
+        valid,
+        invalid,        // Unused, torn or corrupted
+        bus_error,
+    };
+
+    /**
+     * Read a page of the range, and check its CRC
+     */
+    PageStatus read_page(uint16_t index, Page& page) const;
+
+    /**
+     * Newest valid page by scanning the whole range, for when page 0 can't be used
+     * as the reference of the binary search
+     * Return false on bus faillure, newest is empty if there is no valid page
+     */
+    bool scan(std::optional<uint16_t>& newest, uint32_t& sequence) const;
+
+    static uint16_t crc(const Page& page);
+
+    uint16_t address(uint16_t index) const { return (_first_page + index) * PAGE_SIZE; }
+
+    const AT24C256<safe_mode>& _eeprom;
+    uint16_t _first_page;
+    uint16_t _page_count;
+
+    bool _mounted = false;
+
+    // Page being filled, in RAM, and its index in the range
+    Page _tail;
+    uint16_t _tail_index = 0;
+};
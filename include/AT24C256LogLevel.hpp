@@ -0,0 +1,14 @@
+#pragma once
+
+/**
+ * Log level of the library sources, included by each of them before anything else
+ * 
+ * Build with -DAT24C256_LOG_LEVEL=<level> (ESP_LOG_WARN for instance) to compile out
+ * every library log above that level: per-transfer debug logs and hexdumps disappear,
+ * level checks and argument evaluation included. safe_mode checks are not affected.
+ * When not defined, LOG_LOCAL_LEVEL keeps its default (CONFIG_LOG_MAXIMUM_LEVEL).
+ */
+#ifdef AT24C256_LOG_LEVEL
+#undef LOG_LOCAL_LEVEL
+#define LOG_LOCAL_LEVEL AT24C256_LOG_LEVEL
+#endif
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <bitset>
+#include <cstddef>
+#include <cstring>
+#include <span>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "AT24C256.hpp"
+
+/**
+ * RAM mirror of the whole chip, for pointer-like access to read-mostly data
+ * 
+ * Pages are loaded from the chip the first time they are accessed, once:
+ * after that, reads run at RAM speed. Writes go to RAM and mark their pages
+ * dirty, a low priority task writes dirty pages back sync_delay_ms after
+ * the first write, so that bursts of writes are batched.
+ * 
+ * The mirror must be used from a single task, and the device must not be
+ * used directly while the mirror exists.
+ */
+template<bool safe_mode = true>
+class AT24C256Mirror
+{
+public:
+    static constexpr int PAGE_SIZE = AT24C256<safe_mode>::PAGE_SIZE;
+    static constexpr int PAGE_COUNT = AT24C256<safe_mode>::PAGE_COUNT;
+    static constexpr int MEMORY_SIZE = AT24C256<safe_mode>::MEMORY_SIZE;
+
+    static constexpr uint32_t DEFAULT_SYNC_DELAY_MS = 100;
+    static constexpr UBaseType_t DEFAULT_PRIORITY = 1;
+    static constexpr uint32_t DEFAULT_STACK_SIZE = 3072;
+
+public:
+    /**
+     * Allocate MEMORY_SIZE bytes (in PSRAM if available, internal RAM otherwise) and start the sync task
+     * eeprom must outlive the mirror
+     */
+    AT24C256Mirror(const AT24C256<safe_mode>& eeprom, 
+        uint32_t sync_delay_ms = DEFAULT_SYNC_DELAY_MS, 
+        UBaseType_t priority = DEFAULT_PRIORITY, 
+        uint32_t stack_size = DEFAULT_STACK_SIZE);
+
+    AT24C256Mirror(const AT24C256Mirror &other) = delete;
+    AT24C256Mirror& operator=(const AT24C256Mirror &other) = delete;
+
+    /**
+     * Stop the sync task and write the dirty pages back
+     */
+    ~AT24C256Mirror();
+
+    /**
+     * View of size bytes at address, loading the pages it covers if needed
+     * The view stays valid as long as the mirror, and sees later writes
+     * 
+     * Return an empty span on faillure
+     */
+    std::span<const uint8_t> view(uint16_t address, size_t size);
+
+    /**
+     * View of the whole chip, loading every page not loaded yet
+     */
+    std::span<const uint8_t> view() { return view(0x0000, MEMORY_SIZE); }
+
+    /**
+     * Read arbitrary data from the mirror
+     */
+    template<typename T>
+    requires AT24C256Object<T>
+    auto read(uint16_t address) -> typename std::conditional<safe_mode, std::optional<T>, T>::type
+    {
+        T value{};
+
+        std::span<const uint8_t> data = view(address, sizeof(T));
+
+        if constexpr (safe_mode) 
+        {
+            if(data.empty())
+                return std::nullopt;
+        }
+
+        std::memcpy(&value, data.data(), data.size());
+
+        return value;
+    }
+
+    /**
+     * Write to the mirror, the pages being written back later by the sync task
+     * Pages partially written are loaded first
+     * 
+     * Return false if a page could not be loaded
+     */
+    bool write(uint16_t address, const uint8_t* buffer, size_t size);
+
+    template<typename T>
+    requires AT24C256Object<T>
+    bool write(uint16_t address, const T& value)
+    {
+        return write(address, (const uint8_t*) &value, sizeof(T));
+    }
+
+    /**
+     * Write the dirty pages back now, from the calling task
+     * Waits for a pass of the sync task in progress first
+     * 
+     * Return false on faillure, the pages not written staying dirty
+     */
+    bool flush();
+
+    /**
+     * Whether some pages are waiting to be written back
+     */
+    bool pending() const;
+
+    bool loaded(uint16_t page) const { return _loaded[page]; }
+
+private:
+    /**
+     * Load the pages covering size bytes at address that are not loaded yet
+     * Consecutive pages are read together
+     */
+    bool load(uint16_t address, size_t size);
+
+    /**
+     * Write every dirty page back, a page at a time
+     * Passes are serialized: a page is either dirty or on the chip once no pass runs
+     */
+    bool sync();
+
+    static void sync_task(void* arg);
+
+    const AT24C256<safe_mode>& _eeprom;
+    uint32_t _sync_delay_ms;
+
+    uint8_t* _memory;
+
+    // Only changed by the user task
+    std::bitset<PAGE_COUNT> _loaded;
+
+    // Shared with the sync task, protected by _lock as well as dirty page contents
+    std::bitset<PAGE_COUNT> _dirty;
+    SemaphoreHandle_t _lock;
+
+    // Serializes the device between the user task and the sync task
+    SemaphoreHandle_t _bus;
+
+    // Held for a whole sync() pass
+    SemaphoreHandle_t _sync;
+
+    SemaphoreHandle_t _wake;
+    SemaphoreHandle_t _stopped;
+    volatile bool _stop = false;
+};
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+#include "AT24C256.hpp"
+
+/**
+ * A write-back RAM cache of AT24C256 pages
+ * 
+ * Writes are stored in cached pages and only reach the chip on flush()
+ * or when a dirty page is evicted (least recently used first). Several
+ * writes to the same page thus cost a single write cycle.
+ * Reads are served from the cache when the page is resident, and go
+ * straight to the chip otherwise (without loading the page).
+ * 
+ * All the pages are allocated by the constructor, the cache does not
+ * allocate afterwards.
+ * 
+ * The cache does not see writes made directly on the chip: bypassing it
+ * while it holds pages requires calling invalidate() first.
+ */
+template<bool safe_mode = true>
+class AT24C256PageCache
+{
+public:
+    static constexpr int PAGE_SIZE = AT24C256<safe_mode>::PAGE_SIZE;
+    static constexpr int MEMORY_SIZE = AT24C256<safe_mode>::MEMORY_SIZE;
+
+public:
+    /**
+     * eeprom must outlive the cache
+     * capacity is the amount of pages that can be held in RAM
+     */
+    AT24C256PageCache(const AT24C256<safe_mode>& eeprom, size_t capacity);
+
+    AT24C256PageCache(const AT24C256PageCache &other) = delete;
+    AT24C256PageCache& operator=(const AT24C256PageCache &other) = delete;
+
+    /**
+     * Flush dirty pages
+     */
+    ~AT24C256PageCache();
+
+    /**
+     * Write a sequence of bytes into the cache
+     * Pages that are not resident and only partially written are first
+     * loaded from the chip
+     * 
+     * Return true on success, false on faillure
+     * On faillure, check logs for more info
+     */
+    bool write(uint16_t address, const uint8_t* buffer, uint16_t size);
+
+    /**
+     * Write arbitrary data into the cache
+     */
+    template<typename T>
+    requires AT24C256Object<T>
+    bool write(uint16_t address, const T& value)
+    {
+        return write(address, (const uint8_t*) &value, sizeof(T));
+    }
+
+    /**
+     * Read a sequence of bytes, from the cache for resident pages
+     * and from the chip for the others
+     * 
+     * Return true on success, false on faillure
+     */
+    bool read(uint16_t address, uint8_t* buffer, size_t size);
+
+    /**
+     * Read arbitrary data
+     */
+    template<typename T>
+    requires AT24C256Object<T>
+    auto read(uint16_t address) -> typename std::conditional<safe_mode, std::optional<T>, T>::type
+    {
+        T value;
+
+        bool result = read(address, (uint8_t*) &value, sizeof(T));
+
+        if constexpr (safe_mode) 
+        {
+            if(!result)
+                return std::nullopt;
+        }
+
+        return value;
+    }
+
+    /**
+     * Write every dirty page to the chip, one write cycle per page
+     * Pages stay resident
+     * 
+     * Return false if at least one page could not be written
+     */
+    bool flush();
+
+    /**
+     * Drop every cached page, dirty or not, without writing them
+     */
+    void invalidate();
+
+    /**
+     * Amount of pages the cache can hold
+     */
+    size_t capacity() const { return _entries.size(); }
+
+private:
+    struct Entry
+    {
+        bool valid = false;
+        uint16_t page = 0;
+        uint32_t last_use = 0;
+        std::bitset<PAGE_SIZE> dirty;
+        std::array<uint8_t, PAGE_SIZE> data;
+    };
+
+    /**
+     * Return the entry holding page, nullptr if not resident
+     */
+    Entry* find(uint16_t page);
+
+    /**
+     * Make room for page (evicting the least recently used one) and
+     * load it from the chip if fetch is true
+     * 
+     * Return nullptr on faillure
+     */
+    Entry* load(uint16_t page, bool fetch);
+
+    /**
+     * Write the dirty range of a page to the chip, in a single write cycle
+     */
+    bool write_back(Entry& entry);
+
+    const AT24C256<safe_mode>& _eeprom;
+    std::vector<Entry> _entries;
+    uint32_t _clock = 0;
+};
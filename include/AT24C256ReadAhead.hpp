@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+#include "AT24C256.hpp"
+
+/**
+ * Read-ahead for sequential walks made of many small reads (parsing a
+ * configuration record field by field, for instance)
+ * 
+ * When a read starts where the previous one ended, the next window bytes
+ * are fetched in a single transfer, and the following reads are served
+ * from RAM. Other reads go straight to the chip.
+ * 
+ * Writes made through the object update the window. Writes made directly
+ * on the chip require calling invalidate() first.
+ */
+template<bool safe_mode = true>
+class AT24C256ReadAhead
+{
+public:
+    static constexpr int MEMORY_SIZE = AT24C256<safe_mode>::MEMORY_SIZE;
+    static constexpr size_t DEFAULT_WINDOW = 128;
+
+public:
+    /**
+     * eeprom must outlive the object
+     * window is the amount of bytes fetched at once, allocated by the constructor
+     */
+    AT24C256ReadAhead(const AT24C256<safe_mode>& eeprom, size_t window = DEFAULT_WINDOW);
+
+    AT24C256ReadAhead(const AT24C256ReadAhead &other) = delete;
+    AT24C256ReadAhead& operator=(const AT24C256ReadAhead &other) = delete;
+
+    /**
+     * Read a sequence of bytes, from the window when it holds them
+     * 
+     * Return true on success, false on faillure
+     */
+    bool read(uint16_t address, uint8_t* buffer, size_t size);
+
+    /**
+     * Read arbitrary data
+     */
+    template<typename T>
+    requires AT24C256Object<T>
+    auto read(uint16_t address) -> typename std::conditional<safe_mode, std::optional<T>, T>::type
+    {
+        T value;
+
+        bool result = read(address, (uint8_t*) &value, sizeof(T));
+
+        if constexpr (safe_mode) 
+        {
+            if(!result)
+                return std::nullopt;
+        }
+
+        return value;
+    }
+
+    /**
+     * Write through to the chip, updating the window
+     * 
+     * Return true on success, false on faillure
+     */
+    bool write(uint16_t address, const uint8_t* buffer, uint16_t size);
+
+    /**
+     * Drop the window
+     */
+    void invalidate();
+
+    size_t window() const { return _window.size(); }
+
+private:
+    const AT24C256<safe_mode>& _eeprom;
+
+    // Bytes [_start, _start+_size) of the chip
+    std::vector<uint8_t> _window;
+    uint32_t _start = 0;
+    size_t _size = 0;
+
+    // Where a sequential read would start
+    uint32_t _next = 0;
+};
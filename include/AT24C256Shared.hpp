@@ -0,0 +1,147 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <utility>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include "AT24C256.hpp"
+
+/**
+ * Thread-safe access to an AT24C256 shared by several FreeRTOS tasks
+ * 
+ * Each operation runs under a mutex held for its whole duration, a multi-page
+ * write can't be interleaved with another task's operation.
+ * 
+ * Operations issued while the bus is busy are queued. The task that gets the
+ * mutex next executes every queued operation at once, sorted by address:
+ * writes from several tasks that land contiguously in the same page are merged
+ * into a single write cycle. The other tasks then return without touching the bus.
+ * Overlapping operations, one of them at least being a write, keep their
+ * arrival order: the most recent write wins.
+ * 
+ * Merged writes go through AT24C256::write(): config.skip_unchanged and
+ * config.verify_writes apply to each merged page.
+ * 
+ * The device must not be used directly while shared, except through with_lock().
+ */
+template<bool safe_mode = true>
+class AT24C256Shared
+{
+public:
+    static constexpr int PAGE_SIZE = AT24C256<safe_mode>::PAGE_SIZE;
+    static constexpr int MEMORY_SIZE = AT24C256<safe_mode>::MEMORY_SIZE;
+
+public:
+    /**
+     * eeprom must outlive the object
+     */
+    AT24C256Shared(const AT24C256<safe_mode>& eeprom);
+
+    AT24C256Shared(const AT24C256Shared &other) = delete;
+    AT24C256Shared& operator=(const AT24C256Shared &other) = delete;
+
+    ~AT24C256Shared();
+
+    /**
+     * Write a sequence of bytes anywhere on the chip
+     * 
+     * Return true on success, false on faillure
+     */
+    bool write(uint16_t address, const uint8_t* buffer, uint16_t size);
+
+    /**
+     * Write arbitrary data
+     */
+    template<typename T>
+    requires AT24C256Object<T>
+    bool write(uint16_t address, const T& value)
+    {
+        return write(address, (const uint8_t*) &value, sizeof(T));
+    }
+
+    /**
+     * Read a sequence of bytes
+     * 
+     * Return true on success, false on faillure
+     */
+    bool read(uint16_t address, uint8_t* buffer, size_t size);
+
+    /**
+     * Read arbitrary data
+     */
+    template<typename T>
+    requires AT24C256Object<T>
+    auto read(uint16_t address) -> typename std::conditional<safe_mode, std::optional<T>, T>::type
+    {
+        T value;
+
+        bool result = read(address, (uint8_t*) &value, sizeof(T));
+
+        if constexpr (safe_mode) 
+        {
+            if(!result)
+                return std::nullopt;
+        }
+
+        return value;
+    }
+
+    /**
+     * Call f(eeprom) with the mutex held, to run a sequence of
+     * operations that must not be interleaved with other tasks
+     */
+    template<typename F>
+    decltype(auto) with_lock(F&& f)
+    {
+        Lock lock(_mutex);
+
+        return std::forward<F>(f)(_eeprom);
+    }
+
+private:
+    struct Lock
+    {
+        Lock(SemaphoreHandle_t mutex) : _mutex(mutex) { xSemaphoreTake(_mutex, portMAX_DELAY); }
+        ~Lock() { xSemaphoreGive(_mutex); }
+
+        SemaphoreHandle_t _mutex;
+    };
+
+    struct Request
+    {
+        bool write = false;
+        uint16_t address = 0;
+        uint8_t* buffer = nullptr;
+        size_t size = 0;
+
+        bool done = false;
+        bool result = true;
+        Request* next = nullptr;
+    };
+
+    /**
+     * Queue a request and wait for it to be executed,
+     * by the calling task or by another one
+     */
+    bool submit(Request& request);
+
+    /**
+     * Execute every queued request, mutex held
+     */
+    void combine();
+
+    /**
+     * Whether a and b overlap, one of them at least being a write
+     */
+    static bool conflicts(const Request& a, const Request& b);
+
+    const AT24C256<safe_mode>& _eeprom;
+    SemaphoreHandle_t _mutex;
+
+    // Queued requests (most recent first), guarded by _spinlock
+    portMUX_TYPE _spinlock = portMUX_INITIALIZER_UNLOCKED;
+    Request* _pending = nullptr;
+};
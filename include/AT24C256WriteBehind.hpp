@@ -0,0 +1,202 @@
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <span>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+
+#if CONFIG_PM_ENABLE
+#include "esp_pm.h"
+#endif
+
+#include "AT24C256.hpp"
+
+struct AT24C256WriteBehindConfig
+{
+    UBaseType_t priority = 1;
+
+    // Batching: queued writes wait for up to batch_deadline_ms after the task
+    // wakes up, or until batch_pages pages are queued (0: drain at once)
+    // A full queue is drained at once
+    uint32_t batch_deadline_ms = 0;
+    size_t batch_pages = 1;
+
+    // With a deferred device, sleep this long after each page write before
+    // ACK polling, so that the CPU idles during the write cycle (0: poll at once)
+    uint32_t write_cycle_sleep_us = 0;
+};
+
+/**
+ * Write-behind queue: write() copies the data to a ring of page slots and
+ * returns, a low priority task programs the chip in the background
+ * 
+ * Writes to a page already queued are merged into its slot, so a page
+ * rewritten while the chip is busy costs a single write cycle. Queued slots
+ * are drained in page order, a batch at a time. Slots, task stack and
+ * semaphores are members of the object: only the write cycle timer and
+ * the PM lock are allocated. The object is about 5 KB, more than the
+ * default main task stack: make it static, or allocate it.
+ * 
+ * Reads see the queued data. The device must not be used directly while
+ * the queue exists.
+ * 
+ * For battery powered devices, writes can be held back and programmed as a
+ * single burst (see AT24C256WriteBehindConfig). With CONFIG_PM_ENABLE, the
+ * task holds an APB lock during the burst only, releasing it while it sleeps
+ * through write cycles: automatic light sleep can kick in then.
+ */
+template<bool safe_mode = true>
+class AT24C256WriteBehind
+{
+public:
+    static constexpr int PAGE_SIZE = AT24C256<safe_mode>::PAGE_SIZE;
+
+    static constexpr size_t SLOT_COUNT = 16;
+    static constexpr UBaseType_t DEFAULT_PRIORITY = 1;
+    static constexpr uint32_t STACK_SIZE = 3072;
+
+public:
+    /**
+     * Start the drain task
+     * eeprom must outlive the object
+     */
+    AT24C256WriteBehind(const AT24C256<safe_mode>& eeprom, UBaseType_t priority = DEFAULT_PRIORITY);
+
+    /**
+     * Start the drain task, with batching and write cycle sleeps
+     */
+    AT24C256WriteBehind(const AT24C256<safe_mode>& eeprom, const AT24C256WriteBehindConfig& config);
+
+    AT24C256WriteBehind(const AT24C256WriteBehind &other) = delete;
+    AT24C256WriteBehind& operator=(const AT24C256WriteBehind &other) = delete;
+
+    /**
+     * Drain the queue, then stop the task
+     */
+    ~AT24C256WriteBehind();
+
+    /**
+     * Queue a write, merged into the slots of the pages already queued
+     * Never blocks on the chip: either every page of the write is queued, or none
+     * 
+     * Return false if there are not enough free slots
+     */
+    bool write(uint16_t address, const uint8_t* buffer, size_t size);
+
+    template<typename T>
+    requires AT24C256Object<T>
+    bool write(uint16_t address, const T& value)
+    {
+        return write(address, (const uint8_t*) &value, sizeof(T));
+    }
+
+    /**
+     * Read from the chip, with the queued data on top
+     * 
+     * Return true on success, false on faillure
+     */
+    bool read(uint16_t address, uint8_t* buffer, size_t size);
+
+    /**
+     * Wait for every queued write to be programmed, for up to timeout
+     * Queued writes are programmed at once, without waiting for the batch deadline
+     * Meant for shutdown paths (esp_register_shutdown_handler() for instance):
+     * it must be called from a task, not from an interrupt
+     * 
+     * Return false on timeout, or if a write failed since the last flush()
+     */
+    bool flush(TickType_t timeout = portMAX_DELAY);
+
+    /**
+     * Number of slots queued or being programmed
+     */
+    size_t pending() const;
+
+private:
+    struct Slot
+    {
+        uint16_t page;
+        std::bitset<PAGE_SIZE> valid;
+        std::array<uint8_t, PAGE_SIZE> data;
+    };
+
+    /**
+     * Find the queued slot of page, among the ones the task has not taken yet
+     */
+    Slot* find(uint16_t page);
+
+    /**
+     * Program the valid bytes of a slot: a single write cycle, the gaps
+     * being read from the chip first
+     */
+    bool program(Slot& slot);
+
+    /**
+     * Batching: wait for the batch deadline or threshold, unless a flush or
+     * the destructor asks for the queue to be drained
+     */
+    void hold();
+
+    /**
+     * Sleep until the write cycle of the last page is likely over, if it is
+     * still running, with the PM lock released
+     */
+    void sleep_write_cycle();
+
+    void pm_acquire();
+    void pm_release();
+
+    static void drain_task(void* arg);
+
+    static void write_cycle_timer_callback(void* arg);
+
+    const AT24C256<safe_mode>& _eeprom;
+    const AT24C256WriteBehindConfig _config;
+
+    // Ring of slots: [_tail, _tail+_count), the first _draining ones being programmed
+    std::array<Slot, SLOT_COUNT> _slots;
+    size_t _tail = 0;
+    size_t _count = 0;
+    size_t _draining = 0;
+    bool _failed = false;
+    bool _flush = false;
+    bool _stop = false;
+
+    // Protects the ring, never held during a transfer
+    SemaphoreHandle_t _lock;
+    StaticSemaphore_t _lock_buffer;
+
+    // Serializes the device between read() and the task
+    SemaphoreHandle_t _bus;
+    StaticSemaphore_t _bus_buffer;
+
+    SemaphoreHandle_t _wake;
+    StaticSemaphore_t _wake_buffer;
+
+    // Given each time the ring becomes empty
+    SemaphoreHandle_t _drained;
+    StaticSemaphore_t _drained_buffer;
+
+    SemaphoreHandle_t _stopped;
+    StaticSemaphore_t _stopped_buffer;
+
+    // Only created with config.write_cycle_sleep_us
+    esp_timer_handle_t _write_cycle_timer = nullptr;
+
+    SemaphoreHandle_t _write_cycle_done;
+    StaticSemaphore_t _write_cycle_done_buffer;
+
+#if CONFIG_PM_ENABLE
+    esp_pm_lock_handle_t _pm_lock = nullptr;
+#endif
+
+    TaskHandle_t _task = nullptr;
+    StaticTask_t _task_buffer;
+    std::array<StackType_t, STACK_SIZE> _stack;
+};
@@ -1,36 +1,109 @@
+#include "AT24C256LogLevel.hpp"
 #include "AT24C256.hpp"
 
+#include <algorithm>
 #include <array>
-#include <vector>
+#include <bitset>
+#include <cinttypes>
+#include <cstring>
+#include "esp_heap_caps.h"
+#include "esp_memory_utils.h"
+#include "esp_timer.h"
+#include "esp_rom_crc.h"
+#include "esp_rom_sys.h"
 #include "freertos/FreeRTOS.h"
 
-template<bool safe_mode>
-AT24C256<safe_mode>::AT24C256(i2c_master_bus_handle_t bus, uint8_t address) : _address(address)
+template<bool safe_mode, typename Geometry>
+int AT24C256<safe_mode, Geometry>::transfer_timeout_ms(size_t size) const
 {
+    // Only checked in safe_mode
+    uint32_t scl_speed_hz = _config.scl_speed_hz ? _config.scl_speed_hz : I2C_MASTER_FREQ_HZ;
+
+    // 9 clocks per byte, address byte included
+    return _config.xfer_timeout_ms + ((size + 1) * 9 * 1000) / scl_speed_hz + 1;
+}
+
+template<bool safe_mode, typename Geometry>
+template<typename Transfer>
+esp_err_t AT24C256<safe_mode, Geometry>::with_retries(size_t size, Transfer&& transfer) const
+{
+    int timeout_ms = transfer_timeout_ms(size);
+    uint32_t backoff_us = _config.retry_backoff_us;
+
+    for(uint8_t attempt = 1; ; ++attempt)
+    {
+        esp_err_t err = transfer(timeout_ms);
+
+        if(err == ESP_OK)
+            return err;
+
+        stats_nack();
+
+        if(err == ESP_ERR_INVALID_ARG || attempt >= _config.max_attempts)
+            return err;
+
+        stats_retry();
+        ESP_LOGD("AT24C256::with_retries", "[0x%02x] - Attempt %u failed: [%u] %s, retrying in %" PRIu32 " us", _address, attempt, err, esp_err_to_name(err), backoff_us);
+
+        // Short backoffs spin, longer ones sleep for at least a tick
+        if(backoff_us <= MAX_BACKOFF_SPIN_US)
+            esp_rom_delay_us(backoff_us);
+        else
+            vTaskDelay(std::max<TickType_t>(1, backoff_us / (portTICK_PERIOD_MS * 1000)));
+
+        backoff_us = std::min(backoff_us * 2, _config.retry_backoff_max_us);
+    }
+}
+
+template<bool safe_mode, typename Geometry>
+AT24C256<safe_mode, Geometry>::AT24C256(i2c_master_bus_handle_t bus, uint8_t address, const AT24C256Config& config) : _address(address), _config(config), _bus(bus)
+{
+    if constexpr (safe_mode)
+    {
+        if(_config.scl_speed_hz == 0 || _config.scl_speed_hz > I2C_MASTER_FREQ_HZ_MAX)
+        {
+            ESP_LOGE("AT24C256::AT24C256", "[0x%02x] - SCL speed %" PRIu32 " Hz is out of range (max: %d Hz), using %d Hz", _address, _config.scl_speed_hz, I2C_MASTER_FREQ_HZ_MAX, I2C_MASTER_FREQ_HZ);
+            _config.scl_speed_hz = I2C_MASTER_FREQ_HZ;
+        }
+        else if(_config.scl_speed_hz > I2C_MASTER_FREQ_HZ_FAST)
+        {
+            ESP_LOGW("AT24C256::AT24C256", "[0x%02x] - SCL speed %" PRIu32 " Hz requires VCC >= 4.5 V", _address, _config.scl_speed_hz);
+        }
+    }
+
     _dev_cfg = {
         .dev_addr_length = I2C_ADDR_BIT_LEN_7,
         .device_address = address,
-        .scl_speed_hz = I2C_MASTER_FREQ_HZ,
+        .scl_speed_hz = _config.scl_speed_hz,
         .scl_wait_us = 0,
         .flags = { .disable_ack_check = false }
     };
 
-    ESP_LOGD("AT24C256::AT24C256", "[0x%02x] - Registering device", _address);
+    ESP_LOGD("AT24C256::AT24C256", "[0x%02x] - Registering device @ %" PRIu32 " Hz", _address, _config.scl_speed_hz);
     ESP_ERROR_CHECK(i2c_master_bus_add_device(bus, &_dev_cfg, &_dev_handle));
 }
 
-template<bool safe_mode>
-AT24C256<safe_mode>::AT24C256(AT24C256<safe_mode> &&other)
+template<bool safe_mode, typename Geometry>
+AT24C256<safe_mode, Geometry>::AT24C256(AT24C256 &&other)
 {
     _address = other._address;
     other._address = 0;
 
+    _config = other._config;
+    _bus = other._bus;
+    _write_pending = other._write_pending;
+    _current_address = other._current_address;
+
+#if AT24C256_STATS
+    _stats = other._stats;
+#endif
+
     _dev_handle = other._dev_handle;
     other._dev_handle = nullptr;
 }
 
-template<bool safe_mode>
-AT24C256<safe_mode>::~AT24C256()
+template<bool safe_mode, typename Geometry>
+AT24C256<safe_mode, Geometry>::~AT24C256()
 {
     if(_dev_handle)
     {
@@ -39,20 +112,29 @@ AT24C256<safe_mode>::~AT24C256()
     } 
 }
 
-template<bool safe_mode>
-AT24C256<safe_mode>& AT24C256<safe_mode>::operator=(AT24C256<safe_mode> &&other)
+template<bool safe_mode, typename Geometry>
+AT24C256<safe_mode, Geometry>& AT24C256<safe_mode, Geometry>::operator=(AT24C256 &&other)
 {
     _address = other._address;
     other._address = 0;
 
+    _config = other._config;
+    _bus = other._bus;
+    _write_pending = other._write_pending;
+    _current_address = other._current_address;
+
+#if AT24C256_STATS
+    _stats = other._stats;
+#endif
+
     _dev_handle = other._dev_handle;
     other._dev_handle = nullptr;
 
     return *this;
 }
 
-template<bool safe_mode>
-bool AT24C256<safe_mode>::write(uint16_t address, uint8_t byte) const
+template<bool safe_mode, typename Geometry>
+bool AT24C256<safe_mode, Geometry>::write(uint16_t address, uint8_t byte) const
 {
     if constexpr (safe_mode)
     {
@@ -63,13 +145,22 @@ bool AT24C256<safe_mode>::write(uint16_t address, uint8_t byte) const
         }
     }
 
+    int64_t start = stats_start();
+
+    if(!wait_ready())
+        return false;
+
     std::array<uint8_t, 3> payload{
         (uint8_t)(address >> 8),        // First word address
         (uint8_t)address,               // Second word address
         byte  
     };
 
-    esp_err_t err = i2c_master_transmit(_dev_handle, payload.data(), payload.size(), -1);
+    _current_address.reset();
+
+    esp_err_t err = with_retries(payload.size(), [&](int timeout_ms) {
+        return i2c_master_transmit(_dev_handle, payload.data(), payload.size(), timeout_ms);
+    });
     
     if (err != ESP_OK) 
     {
@@ -78,28 +169,46 @@ bool AT24C256<safe_mode>::write(uint16_t address, uint8_t byte) const
     }
 
     ESP_LOGD("AT24C256::write", "[0x%02x] - Wrote byte 0x%02x @ 0x%04x", _address, byte, address);
-    vTaskDelay(25 / portTICK_PERIOD_MS);  // 25 milliseconds
 
-    return true;
+    bool result = end_write();
+    stats_write(1, start);
+
+    return result;
 }
 
-template<bool safe_mode>
-bool AT24C256<safe_mode>::write(uint16_t address, uint8_t* buffer, uint16_t size) const
+template<bool safe_mode, typename Geometry>
+bool AT24C256<safe_mode, Geometry>::write(uint16_t address, uint8_t* buffer, uint16_t size, uint16_t* programmed) const
 {
     if constexpr (safe_mode)
     {
-        if((address+size) > MEMORY_SIZE-1)
+        if(address + size > MEMORY_SIZE)
         {
-            ESP_LOGE("AT24C256::write", "[0x%02x] - Address 0x%02x is too big (max address: 0x%02x)", _address, address, MEMORY_SIZE-1);
+            ESP_LOGE("AT24C256::write", "[0x%02x] - Write of %u bytes @ 0x%04x is too big (max address: 0x%02x)", _address, size, address, MEMORY_SIZE-1);
+
+            if(programmed)
+                *programmed = 0;
+
             return false;
         }
     }
 
+    return write_unchecked(address, buffer, size, programmed);
+}
+
+template<bool safe_mode, typename Geometry>
+bool AT24C256<safe_mode, Geometry>::write_unchecked(uint16_t address, uint8_t* buffer, uint16_t size, uint16_t* programmed) const
+{
+    if(programmed)
+        *programmed = 0;
+
+    if(size == 0)
+        return true;
+
     ESP_LOGD("AT24C256::write", "[0x%02x] - Size: %u", _address, size);
     ESP_LOG_BUFFER_HEXDUMP("AT24C256::write", buffer, size, ESP_LOG_DEBUG);
 
-    uint16_t start_page = address >> 6;
-    uint16_t end_page = (address+size-1) >> 6;
+    uint16_t start_page = address >> PAGE_SHIFT;
+    uint16_t end_page = (address+size-1) >> PAGE_SHIFT;
 
     uint16_t page_count = (end_page - start_page) + 1;
 
@@ -113,11 +222,36 @@ bool AT24C256<safe_mode>::write(uint16_t address, uint8_t* buffer, uint16_t size
     {
         ESP_LOGD("AT24C256::write", "[0x%02x] - remaining_size: %u, current_addr: Ox%02x, current_buffer: %p", _address, remaining_size, current_addr, current_buffer);
 
-        uint16_t next_page_addr = ((start_page+i+1) << 6);
-        uint16_t page_byte_remaining = next_page_addr - current_addr;
-        uint8_t byte_count = std::min(remaining_size, page_byte_remaining);
+        // 0x10000 past the last page of a 64 KB chip
+        uint32_t next_page_addr = ((start_page+i+1) << PAGE_SHIFT);
+        uint32_t page_byte_remaining = next_page_addr - current_addr;
+        uint8_t byte_count = std::min<uint32_t>(remaining_size, page_byte_remaining);
+
+        // Span of the page to program
+        uint8_t first = 0;
+        uint8_t count = byte_count;
 
-        bool result = write_page(current_addr, current_buffer, byte_count);
+        if(_config.skip_unchanged)
+        {
+            std::array<uint8_t, PAGE_SIZE> current;
+
+            if(!read_unchecked(current_addr, current.data(), byte_count))
+            {
+                ESP_LOGE("AT24C256::write", "[0x%02x] - Compare read failled @ 0x%04x", _address, current_addr);
+                return false;
+            }
+
+            // First differing byte
+            first = std::mismatch(current_buffer, current_buffer + byte_count, current.begin()).first - current_buffer;
+
+            // Last differing byte
+            while(count > first && current_buffer[count-1] == current[count-1])
+                --count;
+
+            count -= first;
+        }
+
+        bool result = count == 0 || write_page_unchecked(current_addr + first, current_buffer + first, count);
 
         if(!result)
         {
@@ -125,40 +259,100 @@ bool AT24C256<safe_mode>::write(uint16_t address, uint8_t* buffer, uint16_t size
             return false;
         }
 
+        if(programmed)
+            *programmed += count;
+
         remaining_size -= byte_count;
         current_addr += byte_count;
         current_buffer += byte_count;
     }
 
+    if(_config.verify_writes)
+    {
+        uint32_t crc = 0;
+
+        if(!crc32(address, size, crc))
+            return false;
+
+        if(crc != esp_rom_crc32_le(0, buffer, size)) [[unlikely]]
+        {
+            ESP_LOGE("AT24C256::write", "[0x%02x] - Verification failled: %u bytes @ 0x%04x", _address, size, address);
+            return false;
+        }
+    }
+
     return true;
 }
 
-template<bool safe_mode>
-bool AT24C256<safe_mode>::write_page(uint16_t address, uint8_t* buffer, uint16_t size) const
+template<bool safe_mode, typename Geometry>
+bool AT24C256<safe_mode, Geometry>::write_page(uint16_t address, uint8_t* buffer, uint16_t size) const
 {
     if constexpr (safe_mode)
     {
-        if(address & 0x8000) [[unlikely]]
+        if(address & ~ADDRESS_MASK) [[unlikely]]
         {
             ESP_LOGE("AT24C256::write_page", "[0x%02x] - Address 0x%02x is too big", _address, address);
             return false;
         }
 
-        if( (address >> 6) != ((address+size-1) >> 6)) [[unlikely]]
+        if( (address >> PAGE_SHIFT) != ((address+size-1) >> PAGE_SHIFT)) [[unlikely]]
         {
             ESP_LOGE("AT24C256::write_page", "[0x%02x] - Write overlap page border", _address);
             return false;
         }
     }
 
-    std::vector<uint8_t> payload(2+size);
+    // Checked even without safe_mode: the staging buffer holds a single page
+    if(size > PAGE_SIZE) [[unlikely]]
+    {
+        ESP_LOGE("AT24C256::write_page", "[0x%02x] - Size %u is bigger than a page", _address, size);
+        return false;
+    }
+
+    return write_page_unchecked(address, buffer, size);
+}
+
+template<bool safe_mode, typename Geometry>
+bool AT24C256<safe_mode, Geometry>::write_page_unchecked(uint16_t address, uint8_t* buffer, uint16_t size) const
+{
+    int64_t start = stats_start();
+
+    if(!wait_ready())
+        return false;
+
+    if(!transmit_page(address, buffer, size))
+        return false;
+
+    bool result = end_write();
+    stats_write(size, start);
+
+    return result;
+}
+
+template<bool safe_mode, typename Geometry>
+bool AT24C256<safe_mode, Geometry>::transmit_page(uint16_t address, const uint8_t* buffer, uint16_t size) const
+{
+    // Staged on the stack
+    Payload payload;
+    std::copy(buffer, buffer+size, payload.begin()+2);
+
+    return transmit_payload(address, payload, size);
+}
+
+template<bool safe_mode, typename Geometry>
+bool AT24C256<safe_mode, Geometry>::transmit_payload(uint16_t address, Payload& payload, uint16_t size) const
+{
     payload[0] = (uint8_t)(address >> 8);
     payload[1] = (uint8_t)address;
-    std::copy(buffer, buffer+size, payload.begin()+2);
 
-    ESP_LOG_BUFFER_HEXDUMP("AT24C256::write_page", payload.data(), payload.size(), ESP_LOG_DEBUG);
+    // Page writes roll over within the page: not worth tracking
+    _current_address.reset();
 
-    esp_err_t err = i2c_master_transmit(_dev_handle, payload.data(), payload.size(), -1);
+    ESP_LOG_BUFFER_HEXDUMP("AT24C256::write_page", payload.data(), 2+size, ESP_LOG_DEBUG);
+
+    esp_err_t err = with_retries(2+size, [&](int timeout_ms) {
+        return i2c_master_transmit(_dev_handle, payload.data(), 2+size, timeout_ms);
+    });
     if (err != ESP_OK) 
     {
         ESP_LOGD("AT24C256::write_page", "[0x%02x] - Multi-write failed: [%u] %s", _address, err, esp_err_to_name(err));
@@ -166,31 +360,307 @@ bool AT24C256<safe_mode>::write_page(uint16_t address, uint8_t* buffer, uint16_t
     }
 
     ESP_LOGD("AT24C256::write_page", "[0x%02x] - Wrote %u bytes @ 0x%04x", _address, size, address);
-    vTaskDelay(25 / portTICK_PERIOD_MS);  // 25 milliseconds
 
     return true;
 }
 
-template<bool safe_mode>
-auto AT24C256<safe_mode>::read(uint16_t address) const -> typename std::conditional<safe_mode, std::optional<uint8_t>, uint8_t>::type
+template<bool safe_mode, typename Geometry>
+bool AT24C256<safe_mode, Geometry>::write_serialized(uint16_t address, uint16_t size, Serializer serialize, const void* object) const
 {
     if constexpr (safe_mode)
     {
-        if(address & 0x8000)
+        if(address + size > MEMORY_SIZE)
+        {
+            ESP_LOGE("AT24C256::write_packed", "[0x%02x] - Invalid write of %u bytes @ 0x%04x", _address, size, address);
+            return false;
+        }
+    }
+
+    Payload payload;
+    uint32_t crc = 0;
+
+    for(uint16_t offset = 0; offset < size; )
+    {
+        uint16_t current_addr = address + offset;
+        uint16_t count = std::min<uint16_t>(size - offset, PAGE_SIZE - (current_addr & PAGE_MASK));
+
+        // Serialized in place, after the word address
+        serialize(object, offset, payload.data()+2, count);
+
+        if(_config.verify_writes)
+            crc = esp_rom_crc32_le(crc, payload.data()+2, count);
+
+        int64_t start = stats_start();
+
+        if(!wait_ready() || !transmit_payload(current_addr, payload, count) || !end_write())
+        {
+            ESP_LOGE("AT24C256::write_packed", "[0x%02x] - Write failled @ 0x%04x", _address, current_addr);
+            return false;
+        }
+
+        stats_write(count, start);
+        offset += count;
+    }
+
+    if(_config.verify_writes)
+    {
+        uint32_t written = 0;
+
+        if(!crc32(address, size, written))
+            return false;
+
+        if(written != crc) [[unlikely]]
         {
-            ESP_LOGE("AT24C256::write", "[0x%02x] - Address 0x%02x is too big", _address, address);
+            ESP_LOGE("AT24C256::write_packed", "[0x%02x] - Verification failled: %u bytes @ 0x%04x", _address, size, address);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+template<bool safe_mode, typename Geometry>
+bool AT24C256<safe_mode, Geometry>::fill(uint8_t value, bool skip_matching, ProgressCallback progress, void* user_data) const
+{
+    // The same page for the whole chip
+    std::array<uint8_t, PAGE_SIZE> page;
+    page.fill(value);
+
+    return program(0x0000, page.data(), MEMORY_SIZE, true, skip_matching, progress, user_data);
+}
+
+template<bool safe_mode, typename Geometry>
+bool AT24C256<safe_mode, Geometry>::erase(bool skip_matching, ProgressCallback progress, void* user_data) const
+{
+    return fill(0xFF, skip_matching, progress, user_data);
+}
+
+template<bool safe_mode, typename Geometry>
+bool AT24C256<safe_mode, Geometry>::program_image(uint16_t address, std::span<const uint8_t> image, bool skip_matching, ProgressCallback progress, void* user_data) const
+{
+    if constexpr (safe_mode)
+    {
+        if(address + image.size() > MEMORY_SIZE)
+        {
+            ESP_LOGE("AT24C256::program_image", "[0x%02x] - Image of %zu bytes @ 0x%04x is too big (max address: 0x%02x)", _address, image.size(), address, MEMORY_SIZE-1);
+            return false;
+        }
+    }
+
+    return program(address, image.data(), image.size(), false, skip_matching, progress, user_data);
+}
+
+template<bool safe_mode, typename Geometry>
+bool AT24C256<safe_mode, Geometry>::program(uint16_t address, const uint8_t* data, size_t size, bool repeat, bool skip_matching, ProgressCallback progress, void* user_data) const
+{
+    uint16_t first_page = address >> PAGE_SHIFT;
+    uint16_t page_count = size == 0 ? 0 : ((address + size - 1) >> PAGE_SHIFT) - first_page + 1;
+
+    size_t offset = 0;
+
+    for(uint16_t i = 0; i < page_count; ++i)
+    {
+        uint16_t current_addr = address + offset;
+        uint16_t count = std::min<size_t>(size - offset, PAGE_SIZE - (current_addr & PAGE_MASK));
+        const uint8_t* source = repeat ? data : data + offset;
+
+        offset += count;
+
+        // ACK polling whatever the configured completion: a fixed delay is far longer than tWR
+        if(_write_pending)
+        {
+            _write_pending = false;
+
+            if(!wait_write_cycle(AT24C256WriteCompletion::ack_polling))
+                return false;
+        }
+
+        bool matching = false;
+
+        if(skip_matching)
+        {
+            std::array<uint8_t, PAGE_SIZE> current;
+
+            if(!read_unchecked(current_addr, current.data(), count))
+                return false;
+
+            matching = std::equal(source, source + count, current.begin());
+        }
+
+        if(!matching)
+        {
+            int64_t start = stats_start();
+
+            if(!transmit_page(current_addr, source, count))
+            {
+                ESP_LOGE("AT24C256::program", "[0x%02x] - Write failled @ 0x%04x", _address, current_addr);
+                return false;
+            }
+
+            _write_pending = true;
+            stats_write(count, start);
+        }
+
+        if(progress)
+            progress(i + 1, page_count, user_data);
+    }
+
+    if(_config.write_completion == AT24C256WriteCompletion::deferred || !_write_pending)
+        return true;
+
+    _write_pending = false;
+
+    return wait_write_cycle(AT24C256WriteCompletion::ack_polling);
+}
+
+template<bool safe_mode, typename Geometry>
+bool AT24C256<safe_mode, Geometry>::writev(std::span<const WriteSegment> segments) const
+{
+    if constexpr (safe_mode)
+    {
+        for(const WriteSegment& segment : segments)
+        {
+            if(segment.address + segment.data.size() > MEMORY_SIZE)
+            {
+                ESP_LOGE("AT24C256::writev", "[0x%02x] - Segment of %zu bytes @ 0x%04x is too big (max address: 0x%02x)", _address, segment.data.size(), segment.address, MEMORY_SIZE-1);
+                return false;
+            }
+        }
+    }
+
+    // Pages in increasing order, found by scanning the segments: no allocation
+    int page = -1;
+
+    while(true)
+    {
+        int next_page = PAGE_COUNT;
+
+        for(const WriteSegment& segment : segments)
+        {
+            if(segment.data.empty())
+                continue;
+
+            int first_page = segment.address >> PAGE_SHIFT;
+            int last_page = (segment.address + segment.data.size() - 1) >> PAGE_SHIFT;
+
+            if(last_page > page)
+                next_page = std::min(next_page, std::max(first_page, page + 1));
+        }
+
+        if(next_page == PAGE_COUNT)
+            return true;
+
+        page = next_page;
+
+        uint16_t page_address = page << PAGE_SHIFT;
+
+        std::array<uint8_t, PAGE_SIZE> staging;
+        std::bitset<PAGE_SIZE> covered;
+        int low = PAGE_SIZE;
+        int high = 0;
+
+        // In the given order: where segments overlap, the last one wins
+        for(const WriteSegment& segment : segments)
+        {
+            int begin = std::max<int>(segment.address, page_address);
+            int end = std::min<int>(segment.address + segment.data.size(), page_address + PAGE_SIZE);
+
+            if(begin >= end)
+                continue;
+
+            std::copy(segment.data.begin() + (begin - segment.address), segment.data.begin() + (end - segment.address), staging.begin() + (begin - page_address));
+
+            for(int i = begin - page_address; i < end - page_address; ++i)
+                covered.set(i);
+
+            low = std::min(low, begin - page_address);
+            high = std::max(high, end - page_address);
+        }
+
+        uint16_t size = high - low;
+
+        // Bytes between segments keep their current value
+        if(covered.count() != size)
+        {
+            std::array<uint8_t, PAGE_SIZE> current;
+
+            if(!read_unchecked(page_address + low, current.data() + low, size))
+            {
+                ESP_LOGE("AT24C256::writev", "[0x%02x] - Gap read failled @ 0x%04x", _address, page_address + low);
+                return false;
+            }
+
+            for(int i = low; i < high; ++i)
+            {
+                if(!covered[i])
+                    staging[i] = current[i];
+            }
+        }
+
+        ESP_LOGD("AT24C256::writev", "[0x%02x] - Page %d: %u bytes @ 0x%04x", _address, page, size, page_address + low);
+
+        if(!write_page_unchecked(page_address + low, staging.data() + low, size))
+            return false;
+    }
+}
+
+template<bool safe_mode, typename Geometry>
+bool AT24C256<safe_mode, Geometry>::write_checked(uint16_t address, const uint8_t* buffer, uint16_t size) const
+{
+    uint32_t crc = esp_rom_crc32_le(0, buffer, size);
+
+    std::array<WriteSegment, 2> segments{{
+        { address, { buffer, size } },
+        { (uint16_t)(address + size), { (const uint8_t*) &crc, CHECKSUM_SIZE } },
+    }};
+
+    if(!writev(segments))
+        return false;
+
+    if(_config.verify_writes)
+    {
+        // Data and checksum together
+        uint32_t written = 0;
+        uint32_t expected = esp_rom_crc32_le(crc, (const uint8_t*) &crc, CHECKSUM_SIZE);
+
+        if(!crc32(address, size + CHECKSUM_SIZE, written))
+            return false;
+
+        if(written != expected) [[unlikely]]
+        {
+            ESP_LOGE("AT24C256::write_checked", "[0x%02x] - Verification failled: %u bytes @ 0x%04x", _address, size, address);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+template<bool safe_mode, typename Geometry>
+auto AT24C256<safe_mode, Geometry>::read(uint16_t address) const -> typename std::conditional<safe_mode, std::optional<uint8_t>, uint8_t>::type
+{
+    if constexpr (safe_mode)
+    {
+        if(address & ~ADDRESS_MASK)
+        {
+            ESP_LOGE("AT24C256::read", "[0x%02x] - Address 0x%02x is too big", _address, address);
             return std::nullopt;
         }
     }
 
-    uint8_t data = 0;
+    int64_t start = stats_start();
 
-    std::array<uint8_t, 2> payload{
-        (uint8_t)(address >> 8),            // First word address
-        (uint8_t)address,                   // Second word address
-    };
+    [[maybe_unused]] bool ready = wait_ready();
 
-    [[maybe_unused]] esp_err_t err = i2c_master_transmit_receive(_dev_handle, payload.data(), payload.size(), &data, 1, -1);
+    if constexpr (safe_mode)
+    {
+        if(!ready)
+            return std::nullopt;
+    }
+
+    uint8_t data = 0;
+
+    [[maybe_unused]] esp_err_t err = receive(address, &data, 1, _config.track_address && _current_address == address);
 
     if constexpr (safe_mode)
     {
@@ -202,40 +672,482 @@ auto AT24C256<safe_mode>::read(uint16_t address) const -> typename std::conditio
     }
 
     ESP_LOGD("AT24C256::read", "[0x%02x] - Read byte 0x%02x @ 0x%04x", _address, data, address);
-    vTaskDelay(25 / portTICK_PERIOD_MS);  // 25 milliseconds
+
+    stats_read(1, start);
 
     return data;    
 }
 
-template<bool safe_mode>
-bool AT24C256<safe_mode>::read(uint16_t address, uint8_t* buffer, size_t size) const
+template<bool safe_mode, typename Geometry>
+bool AT24C256<safe_mode, Geometry>::read(uint16_t address, uint8_t* buffer, size_t size) const
 {
     if constexpr (safe_mode)
     {
-        if(address & 0x8000)
+        if(address + size > MEMORY_SIZE)
         {
-            ESP_LOGE("AT24C256::write", "[0x%02x] - Address 0x%02x is too big", _address, address);
+            ESP_LOGE("AT24C256::read", "[0x%02x] - Read of %zu bytes @ 0x%04x is too big (max address: 0x%02x)", _address, size, address, MEMORY_SIZE-1);
             return false;
         }
     }
 
+    return read_unchecked(address, buffer, size);
+}
+
+template<bool safe_mode, typename Geometry>
+bool AT24C256<safe_mode, Geometry>::read_unchecked(uint16_t address, uint8_t* buffer, size_t size) const
+{
+    int64_t start = stats_start();
+
+    if(!wait_ready())
+        return false;
+
+    esp_err_t err = receive(address, buffer, size, _config.track_address && _current_address == address);
+    if (err != ESP_OK) 
+    {
+        ESP_LOGD("AT24C256::read", "[0x%02x] - Multi-read failed @ 0x%04x: [%u] %s", _address, address, err, esp_err_to_name(err));
+        return false;
+    }
+
+    ESP_LOGD("AT24C256::read", "[0x%02x] - Read %u bytes @ 0x%04x", _address, size, address);
+
+    stats_read(size, start);
+
+    return true;
+}
+
+template<bool safe_mode, typename Geometry>
+bool AT24C256<safe_mode, Geometry>::read_current(uint8_t* buffer, size_t size) const
+{
+    int64_t start = stats_start();
+
+    if(!wait_ready())
+        return false;
+
+    esp_err_t err;
+
+    if(_current_address)
+    {
+        // Retried with the word address if needed
+        err = receive(*_current_address, buffer, size, true);
+    }
+    else
+    {
+        // A failed attempt may have moved the counter: no retry
+        err = i2c_master_receive(_dev_handle, buffer, size, transfer_timeout_ms(size));
+
+        if(err != ESP_OK)
+            stats_nack();
+    }
+
+    if (err != ESP_OK) 
+    {
+        ESP_LOGD("AT24C256::read_current", "[0x%02x] - Current address read failed: [%u] %s", _address, err, esp_err_to_name(err));
+        return false;
+    }
+
+    ESP_LOGD("AT24C256::read_current", "[0x%02x] - Read %u bytes", _address, size);
+
+    stats_read(size, start);
+
+    return true;
+}
+
+template<bool safe_mode, typename Geometry>
+esp_err_t AT24C256<safe_mode, Geometry>::receive(uint16_t address, uint8_t* buffer, size_t size, bool skip_address) const
+{
     std::array<uint8_t, 2> payload{
         (uint8_t)(address >> 8),            // First word address
         (uint8_t)address,                   // Second word address
     };
 
-    esp_err_t err = i2c_master_transmit_receive(_dev_handle, payload.data(), payload.size(), buffer, size, -1);
-    if (err != ESP_OK) 
+    // Only the first attempt skips the word address: a failed
+    // transfer may have moved the counter
+    esp_err_t err = with_retries(payload.size() + size, [&](int timeout_ms) {
+        if(skip_address)
+        {
+            skip_address = false;
+            return i2c_master_receive(_dev_handle, buffer, size, timeout_ms);
+        }
+
+        return i2c_master_transmit_receive(_dev_handle, payload.data(), payload.size(), buffer, size, timeout_ms);
+    });
+
+    if(err == ESP_OK)
+        _current_address = (address + size) & ADDRESS_MASK;
+    else
+        _current_address.reset();
+
+    return err;
+}
+
+template<bool safe_mode, typename Geometry>
+bool AT24C256<safe_mode, Geometry>::read_chunked(uint16_t address, uint8_t* buffer, size_t size, size_t chunk_size) const
+{
+    if constexpr (safe_mode)
     {
-        ESP_LOGD("AT24C256::read", "[0x%02x] - Multi-read failed @ 0x%04x: [%u] %s", _address, address, err, esp_err_to_name(err));
+        if(address + size > MEMORY_SIZE || chunk_size == 0)
+        {
+            ESP_LOGE("AT24C256::read_chunked", "[0x%02x] - Invalid read of %zu bytes @ 0x%04x (chunk size: %zu)", _address, size, address, chunk_size);
+            return false;
+        }
+    }
+
+    // The I2C driver fills the buffer from its ISR: keep PSRAM out of it
+    uint8_t* bounce = nullptr;
+
+    if(esp_ptr_external_ram(buffer))
+    {
+        chunk_size = std::min(chunk_size, size);
+        bounce = (uint8_t*) heap_caps_malloc(chunk_size, MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA);
+
+        if(!bounce)
+        {
+            ESP_LOGE("AT24C256::read_chunked", "[0x%02x] - Could not allocate a %zu bytes bounce buffer", _address, chunk_size);
+            return false;
+        }
+    }
+
+    bool result = true;
+
+    for(size_t offset = 0; offset < size && result; offset += chunk_size)
+    {
+        size_t count = std::min(chunk_size, size - offset);
+
+        if(bounce)
+        {
+            result = read_unchecked(address + offset, bounce, count);
+
+            if(result)
+                std::memcpy(buffer + offset, bounce, count);
+        }
+        else
+        {
+            result = read_unchecked(address + offset, buffer + offset, count);
+        }
+    }
+
+    heap_caps_free(bounce);
+
+    return result;
+}
+
+template<bool safe_mode, typename Geometry>
+bool AT24C256<safe_mode, Geometry>::read_stream(uint16_t address, size_t size, ChunkConsumer consumer, void* user_data, size_t chunk_size) const
+{
+    if constexpr (safe_mode)
+    {
+        if(address + size > MEMORY_SIZE || chunk_size == 0)
+        {
+            ESP_LOGE("AT24C256::read_stream", "[0x%02x] - Invalid read of %zu bytes @ 0x%04x (chunk size: %zu)", _address, size, address, chunk_size);
+            return false;
+        }
+    }
+
+    if(size == 0)
+        return true;
+
+    chunk_size = std::min(chunk_size, size);
+
+    uint8_t* chunk = (uint8_t*) heap_caps_malloc(chunk_size, MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA);
+
+    if(!chunk)
+    {
+        ESP_LOGE("AT24C256::read_stream", "[0x%02x] - Could not allocate a %zu bytes chunk", _address, chunk_size);
+        return false;
+    }
+
+    bool result = true;
+
+    for(size_t offset = 0; offset < size; offset += chunk_size)
+    {
+        size_t count = std::min(chunk_size, size - offset);
+
+        result = read_unchecked(address + offset, chunk, count);
+
+        if(!result || !consumer(address + offset, chunk, count, user_data))
+            break;
+    }
+
+    heap_caps_free(chunk);
+
+    return result;
+}
+
+template<bool safe_mode, typename Geometry>
+bool AT24C256<safe_mode, Geometry>::readv(std::span<const ReadSegment> segments) const
+{
+    if constexpr (safe_mode)
+    {
+        for(const ReadSegment& segment : segments)
+        {
+            if(segment.address + segment.buffer.size() > MEMORY_SIZE)
+            {
+                ESP_LOGE("AT24C256::readv", "[0x%02x] - Segment of %zu bytes @ 0x%04x is too big (max address: 0x%02x)", _address, segment.buffer.size(), segment.address, MEMORY_SIZE-1);
+                return false;
+            }
+        }
+    }
+
+    const size_t none = segments.size();
+
+    // Segments in address order (then in the given order), found by scanning: no allocation
+    auto after = [&](size_t a, size_t b) {
+        return segments[a].address > segments[b].address || (segments[a].address == segments[b].address && a > b);
+    };
+
+    auto next_segment = [&](size_t previous) {
+        size_t next = none;
+
+        for(size_t i = 0; i < segments.size(); ++i)
+        {
+            if(segments[i].buffer.empty() || (previous != none && !after(i, previous)))
+                continue;
+
+            if(next == none || after(next, i))
+                next = i;
+        }
+
+        return next;
+    };
+
+    // Window of consecutive segments read by a single transfer
+    std::array<uint8_t, PAGE_SIZE> staging;
+    size_t first = none;
+    size_t last = none;
+    uint32_t start = 0;
+    uint32_t end = 0;
+
+    auto read_window = [&]() {
+        if(first == none)
+            return true;
+
+        if(first == last)
+            return read_unchecked(start, segments[first].buffer.data(), segments[first].buffer.size());
+
+        if(!read_unchecked(start, staging.data(), end - start))
+            return false;
+
+        for(size_t i = 0; i < segments.size(); ++i)
+        {
+            const ReadSegment& segment = segments[i];
+
+            if(!segment.buffer.empty() && !after(first, i) && !after(i, last))
+                std::memcpy(segment.buffer.data(), staging.data() + (segment.address - start), segment.buffer.size());
+        }
+
+        return true;
+    };
+
+    for(size_t i = next_segment(none); i != none; i = next_segment(i))
+    {
+        const ReadSegment& segment = segments[i];
+        uint32_t segment_end = segment.address + segment.buffer.size();
+
+        if(first != none && segment.address <= end + READV_MAX_GAP && std::max(end, segment_end) - start <= PAGE_SIZE)
+        {
+            last = i;
+            end = std::max(end, segment_end);
+            continue;
+        }
+
+        if(!read_window())
+            return false;
+
+        first = i;
+        last = i;
+        start = segment.address;
+        end = segment_end;
+    }
+
+    return read_window();
+}
+
+template<bool safe_mode, typename Geometry>
+bool AT24C256<safe_mode, Geometry>::read_checked(uint16_t address, uint8_t* buffer, uint16_t size) const
+{
+    uint32_t crc = 0;
+
+    std::array<ReadSegment, 2> segments{{
+        { address, { buffer, size } },
+        { (uint16_t)(address + size), { (uint8_t*) &crc, CHECKSUM_SIZE } },
+    }};
+
+    if(!readv(segments))
+        return false;
+
+    if(crc != esp_rom_crc32_le(0, buffer, size))
+    {
+        ESP_LOGW("AT24C256::read_checked", "[0x%02x] - CRC mismatch: %u bytes @ 0x%04x", _address, size, address);
         return false;
     }
 
-    ESP_LOGD("AT24C256::read", "[0x%02x] - Read %u bytes @ 0x%04x", _address, size, address);
-    vTaskDelay(25 / portTICK_PERIOD_MS);  // 25 milliseconds
-    
     return true;
 }
 
+template<bool safe_mode, typename Geometry>
+bool AT24C256<safe_mode, Geometry>::crc32(uint16_t address, uint16_t size, uint32_t& crc) const
+{
+    crc = 0;
+
+    if constexpr (safe_mode)
+    {
+        if(address + size > MEMORY_SIZE)
+        {
+            ESP_LOGE("AT24C256::crc32", "[0x%02x] - Invalid range of %u bytes @ 0x%04x", _address, size, address);
+            return false;
+        }
+    }
+
+    std::array<uint8_t, PAGE_SIZE> chunk;
+
+    // Not 16 bits: a 64 KB chip would wrap the offset back to 0
+    for(uint32_t offset = 0; offset < size; offset += chunk.size())
+    {
+        uint16_t count = std::min<uint32_t>(chunk.size(), size - offset);
+
+        if(!read_unchecked(address + offset, chunk.data(), count))
+            return false;
+
+        crc = esp_rom_crc32_le(crc, chunk.data(), count);
+    }
+
+    return true;
+}
+
+template<bool safe_mode, typename Geometry>
+bool AT24C256<safe_mode, Geometry>::wait_ready() const
+{
+    if(!_write_pending)
+        return true;
+
+    _write_pending = false;
+
+    return wait_write_cycle(_config.write_completion);
+}
+
+template<bool safe_mode, typename Geometry>
+bool AT24C256<safe_mode, Geometry>::busy() const
+{
+    if(!_write_pending)
+        return false;
+
+    if(i2c_master_probe(_bus, _address, ACK_POLL_XFER_TIMEOUT_MS) != ESP_OK)
+        return true;
+
+    _write_pending = false;
+
+    return false;
+}
+
+template<bool safe_mode, typename Geometry>
+bool AT24C256<safe_mode, Geometry>::end_write() const
+{
+    _write_pending = true;
+
+    if(_config.write_completion == AT24C256WriteCompletion::deferred)
+        return true;
+
+    return wait_ready();
+}
+
+template<bool safe_mode, typename Geometry>
+bool AT24C256<safe_mode, Geometry>::wait_write_cycle(AT24C256WriteCompletion completion) const
+{
+    if(completion == AT24C256WriteCompletion::fixed_delay)
+    {
+        int64_t start = stats_start();
+        vTaskDelay(_config.write_delay_ms / portTICK_PERIOD_MS);
+        stats_wait(0, start);
+        return true;
+    }
+
+    // The chip does not acknowledge its address while the write cycle is running
+    int64_t start = esp_timer_get_time();
+    uint32_t busy_polls = 0;
+
+    while(true)
+    {
+        esp_err_t err = i2c_master_probe(_bus, _address, ACK_POLL_XFER_TIMEOUT_MS);
+        int64_t elapsed = esp_timer_get_time() - start;
+
+        if(err == ESP_OK)
+        {
+            stats_wait(busy_polls, start);
+            ESP_LOGD("AT24C256::wait_write_cycle", "[0x%02x] - Write cycle done after %lld us", _address, elapsed);
+            return true;
+        }
+
+        busy_polls++;
+
+        if(elapsed > _config.write_timeout_us) [[unlikely]]
+        {
+            stats_wait(busy_polls, start);
+            ESP_LOGE("AT24C256::wait_write_cycle", "[0x%02x] - No ACK after %lld us: [%u] %s", _address, elapsed, err, esp_err_to_name(err));
+            return false;
+        }
+    }
+}
+
+template<bool safe_mode, typename Geometry>
+int64_t AT24C256<safe_mode, Geometry>::stats_start() const
+{
+#if AT24C256_STATS
+    return esp_timer_get_time();
+#else
+    return 0;
+#endif
+}
+
+template<bool safe_mode, typename Geometry>
+void AT24C256<safe_mode, Geometry>::stats_read([[maybe_unused]] size_t size, [[maybe_unused]] int64_t start) const
+{
+#if AT24C256_STATS
+    _stats.bytes_read += size;
+    _stats.read_latency.add(esp_timer_get_time() - start);
+#endif
+}
+
+template<bool safe_mode, typename Geometry>
+void AT24C256<safe_mode, Geometry>::stats_write([[maybe_unused]] size_t size, [[maybe_unused]] int64_t start) const
+{
+#if AT24C256_STATS
+    _stats.bytes_written += size;
+    _stats.page_cycles++;
+    _stats.write_latency.add(esp_timer_get_time() - start);
+#endif
+}
+
+template<bool safe_mode, typename Geometry>
+void AT24C256<safe_mode, Geometry>::stats_wait([[maybe_unused]] uint32_t busy_polls, [[maybe_unused]] int64_t start) const
+{
+#if AT24C256_STATS
+    uint32_t elapsed = esp_timer_get_time() - start;
+
+    _stats.busy_polls += busy_polls;
+    _stats.busy_wait_us += elapsed;
+    _stats.wait_latency.add(elapsed);
+#endif
+}
+
+template<bool safe_mode, typename Geometry>
+void AT24C256<safe_mode, Geometry>::stats_nack() const
+{
+#if AT24C256_STATS
+    _stats.nacks++;
+#endif
+}
+
+template<bool safe_mode, typename Geometry>
+void AT24C256<safe_mode, Geometry>::stats_retry() const
+{
+#if AT24C256_STATS
+    _stats.retries++;
+#endif
+}
+
 template class AT24C256<true>;
 template class AT24C256<false>;
+template class AT24C256<true, AT24C64Geometry>;
+template class AT24C256<false, AT24C64Geometry>;
+template class AT24C256<true, AT24C512Geometry>;
+template class AT24C256<false, AT24C512Geometry>;
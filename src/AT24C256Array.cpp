@@ -0,0 +1,142 @@
+#include "AT24C256LogLevel.hpp"
+#include "AT24C256Array.hpp"
+
+#include <algorithm>
+#include <cinttypes>
+
+template<bool safe_mode>
+AT24C256Array<safe_mode>::AT24C256Array(i2c_master_bus_handle_t bus, std::span<const uint8_t> addresses, bool striped, const AT24C256Config& config) 
+    : _striped(striped), _write_completion(config.write_completion)
+{
+    // In both modes: page math divides by the amount of chips
+    if(addresses.empty() || addresses.size() > MAX_CHIPS)
+    {
+        ESP_LOGE("AT24C256Array::AT24C256Array", "%zu chips given (1 to %zu expected)", addresses.size(), MAX_CHIPS);
+        ESP_ERROR_CHECK(ESP_ERR_INVALID_ARG);
+    }
+
+    AT24C256Config chip_config = config;
+
+    if(chip_config.write_completion == AT24C256WriteCompletion::ack_polling)
+        chip_config.write_completion = AT24C256WriteCompletion::deferred;
+
+    _chips.reserve(addresses.size());
+
+    for(uint8_t address : addresses)
+    {
+        _chips.emplace_back(bus, address, chip_config);
+    }
+
+    ESP_LOGD("AT24C256Array::AT24C256Array", "%zu chips, %" PRIu32 " bytes, striped: %d", _chips.size(), size(), _striped);
+}
+
+template<bool safe_mode>
+bool AT24C256Array<safe_mode>::write(uint32_t address, const uint8_t* buffer, size_t size) const
+{
+    if(!check_range("AT24C256Array::write", address, size))
+        return false;
+
+    while(size > 0)
+    {
+        Location location = locate(address, size);
+
+        // Page by page, consecutive pages of a chip are then pipelined with the other chips
+        location.size = std::min<uint16_t>(location.size, PAGE_SIZE - location.address % PAGE_SIZE);
+
+        // Through write() for config.skip_unchanged and config.verify_writes
+        if(!_chips[location.chip].write(location.address, const_cast<uint8_t*>(buffer), location.size))
+        {
+            ESP_LOGE("AT24C256Array::write", "Write failed on chip %zu @ 0x%04x", location.chip, location.address);
+            return false;
+        }
+
+        address += location.size;
+        buffer += location.size;
+        size -= location.size;
+    }
+
+    if(_write_completion == AT24C256WriteCompletion::ack_polling)
+        return wait_ready();
+
+    return true;
+}
+
+template<bool safe_mode>
+bool AT24C256Array<safe_mode>::read(uint32_t address, uint8_t* buffer, size_t size) const
+{
+    if(!check_range("AT24C256Array::read", address, size))
+        return false;
+
+    while(size > 0)
+    {
+        Location location = locate(address, size);
+
+        if(!_chips[location.chip].read(location.address, buffer, location.size))
+        {
+            ESP_LOGE("AT24C256Array::read", "Read failed on chip %zu @ 0x%04x", location.chip, location.address);
+            return false;
+        }
+
+        address += location.size;
+        buffer += location.size;
+        size -= location.size;
+    }
+
+    return true;
+}
+
+template<bool safe_mode>
+bool AT24C256Array<safe_mode>::wait_ready() const
+{
+    bool result = true;
+
+    for(const AT24C256<safe_mode>& chip : _chips)
+    {
+        result &= chip.wait_ready();
+    }
+
+    return result;
+}
+
+template<bool safe_mode>
+auto AT24C256Array<safe_mode>::locate(uint32_t address, size_t size) const -> Location
+{
+    if(_striped)
+    {
+        uint32_t page = address / PAGE_SIZE;
+        uint16_t offset = address % PAGE_SIZE;
+
+        return {
+            .chip = page % _chips.size(),
+            .address = (uint16_t)((page / _chips.size()) * PAGE_SIZE + offset),
+            .size = (uint16_t)std::min<size_t>(size, PAGE_SIZE - offset)
+        };
+    }
+
+    uint16_t offset = address % CHIP_SIZE;
+
+    // Past the last chip (unsafe mode only): wraps around the array
+    return {
+        .chip = (address / CHIP_SIZE) % _chips.size(),
+        .address = offset,
+        .size = (uint16_t)std::min<size_t>(size, CHIP_SIZE - offset)
+    };
+}
+
+template<bool safe_mode>
+bool AT24C256Array<safe_mode>::check_range([[maybe_unused]] const char* tag, [[maybe_unused]] uint32_t address, [[maybe_unused]] size_t size) const
+{
+    if constexpr (safe_mode)
+    {
+        if(address + size > this->size())
+        {
+            ESP_LOGE(tag, "Address 0x%05" PRIx32 " + %zu bytes is too big (max address: 0x%05" PRIx32 ")", address, size, this->size()-1);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+template class AT24C256Array<true>;
+template class AT24C256Array<false>;
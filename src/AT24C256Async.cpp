@@ -0,0 +1,245 @@
+#include "AT24C256LogLevel.hpp"
+#include "AT24C256Async.hpp"
+
+#include <algorithm>
+#include <array>
+#include "esp_heap_caps.h"
+
+template<bool safe_mode>
+AT24C256Async<safe_mode>::AT24C256Async(const AT24C256<safe_mode>& eeprom, size_t queue_depth, UBaseType_t priority, uint32_t stack_size) : _eeprom(eeprom)
+{
+    _queue = xQueueCreate(queue_depth, sizeof(Request));
+    _idle = xSemaphoreCreateBinary();
+    _stopped = xSemaphoreCreateBinary();
+
+    if(!_queue || !_idle || !_stopped)
+    {
+        ESP_LOGE("AT24C256Async::AT24C256Async", "Could not allocate the queue (depth: %zu)", queue_depth);
+        ESP_ERROR_CHECK(ESP_ERR_NO_MEM);
+    }
+
+    if(xTaskCreate(worker, "AT24C256Async", stack_size, this, priority, nullptr) != pdPASS)
+    {
+        ESP_LOGE("AT24C256Async::AT24C256Async", "Could not create the worker task");
+        ESP_ERROR_CHECK(ESP_ERR_NO_MEM);
+    }
+}
+
+template<bool safe_mode>
+AT24C256Async<safe_mode>::~AT24C256Async()
+{
+    enqueue({ .operation = Operation::stop }, portMAX_DELAY);
+    xSemaphoreTake(_stopped, portMAX_DELAY);
+
+    vQueueDelete(_queue);
+    vSemaphoreDelete(_idle);
+    vSemaphoreDelete(_stopped);
+}
+
+template<bool safe_mode>
+bool AT24C256Async<safe_mode>::write_async(uint16_t address, std::span<const uint8_t> data, Callback callback, void* user_data)
+{
+    // In both modes: the worker's write() takes a 16 bits size, a larger one would be truncated
+    if(data.size() > AT24C256<safe_mode>::MEMORY_SIZE)
+    {
+        ESP_LOGE("AT24C256Async::write_async", "Write of %zu bytes is too big (max: %d)", data.size(), AT24C256<safe_mode>::MEMORY_SIZE);
+        return false;
+    }
+
+    return enqueue({
+        .operation = Operation::write,
+        .address = address,
+        .buffer = const_cast<uint8_t*>(data.data()),  // write() does not modify the buffer
+        .size = data.size(),
+        .callback = callback,
+        .user_data = user_data
+    }, 0);
+}
+
+template<bool safe_mode>
+bool AT24C256Async<safe_mode>::read_async(uint16_t address, std::span<uint8_t> buffer, Callback callback, void* user_data)
+{
+    // In both modes: the worker's read() takes a 16 bits size, a larger one would be truncated
+    if(buffer.size() > AT24C256<safe_mode>::MEMORY_SIZE)
+    {
+        ESP_LOGE("AT24C256Async::read_async", "Read of %zu bytes is too big (max: %d)", buffer.size(), AT24C256<safe_mode>::MEMORY_SIZE);
+        return false;
+    }
+
+    return enqueue({
+        .operation = Operation::read,
+        .address = address,
+        .buffer = buffer.data(),
+        .size = buffer.size(),
+        .callback = callback,
+        .user_data = user_data
+    }, 0);
+}
+
+template<bool safe_mode>
+bool AT24C256Async<safe_mode>::read_stream(uint16_t address, size_t size, typename AT24C256<safe_mode>::ChunkConsumer consumer, void* user_data, size_t chunk_size)
+{
+    if constexpr (safe_mode)
+    {
+        if(address + size > AT24C256<safe_mode>::MEMORY_SIZE || chunk_size == 0)
+        {
+            ESP_LOGE("AT24C256Async::read_stream", "Invalid read of %zu bytes @ 0x%04x (chunk size: %zu)", size, address, chunk_size);
+            return false;
+        }
+    }
+
+    if(size == 0)
+        return true;
+
+    chunk_size = std::min(chunk_size, size);
+
+    struct Chunk
+    {
+        uint8_t* data;
+        SemaphoreHandle_t done;
+        bool result;
+    };
+
+    std::array<Chunk, 2> chunks;
+    bool allocated = true;
+
+    for(Chunk& chunk : chunks)
+    {
+        chunk.data = (uint8_t*) heap_caps_malloc(chunk_size, MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA);
+        chunk.done = xSemaphoreCreateBinary();
+        chunk.result = false;
+
+        allocated &= (chunk.data && chunk.done);
+    }
+
+    auto on_read = [](bool success, void* chunk) {
+        static_cast<Chunk*>(chunk)->result = success;
+        xSemaphoreGive(static_cast<Chunk*>(chunk)->done);
+    };
+
+    auto request = [&](size_t offset, Chunk& chunk) {
+        return enqueue({
+            .operation = Operation::read,
+            .address = (uint16_t)(address + offset),
+            .buffer = chunk.data,
+            .size = std::min(chunk_size, size - offset),
+            .callback = on_read,
+            .user_data = &chunk
+        }, portMAX_DELAY);
+    };
+
+    bool result = allocated;
+
+    if(!allocated)
+        ESP_LOGE("AT24C256Async::read_stream", "Could not allocate two %zu bytes chunks", chunk_size);
+
+    // Chunk i is consumed while chunk i+1 is being read
+    bool in_flight = result && request(0, chunks[0]);
+    size_t offset = 0;
+
+    for(size_t i = 0; in_flight; ++i, offset += chunk_size)
+    {
+        Chunk& current = chunks[i % 2];
+        Chunk& next = chunks[(i + 1) % 2];
+
+        size_t next_offset = offset + chunk_size;
+        bool next_in_flight = (next_offset < size) && request(next_offset, next);
+
+        xSemaphoreTake(current.done, portMAX_DELAY);
+        in_flight = next_in_flight;
+
+        if(!current.result)
+        {
+            result = false;
+            break;
+        }
+
+        if(!consumer(address + offset, current.data, std::min(chunk_size, size - offset), user_data))
+            break;
+    }
+
+    // Never free a chunk the worker is still reading into
+    if(in_flight)
+        xSemaphoreTake(chunks[(offset / chunk_size + 1) % 2].done, portMAX_DELAY);
+
+    for(Chunk& chunk : chunks)
+    {
+        heap_caps_free(chunk.data);
+
+        if(chunk.done)
+            vSemaphoreDelete(chunk.done);
+    }
+
+    return result;
+}
+
+template<bool safe_mode>
+bool AT24C256Async<safe_mode>::wait_idle(TickType_t timeout)
+{
+    // Drop a token left by a barrier that previously timed out
+    xSemaphoreTake(_idle, 0);
+
+    TickType_t start = xTaskGetTickCount();
+
+    if(!enqueue({ .operation = Operation::barrier }, timeout))
+        return false;
+
+    TickType_t elapsed = xTaskGetTickCount() - start;
+    TickType_t remaining = (timeout == portMAX_DELAY) ? portMAX_DELAY : (timeout > elapsed ? timeout - elapsed : 0);
+
+    return xSemaphoreTake(_idle, remaining) == pdTRUE;
+}
+
+template<bool safe_mode>
+bool AT24C256Async<safe_mode>::enqueue(const Request& request, TickType_t timeout)
+{
+    if(xQueueSend(_queue, &request, timeout) != pdTRUE)
+    {
+        ESP_LOGD("AT24C256Async::enqueue", "Queue is full");
+        return false;
+    }
+
+    return true;
+}
+
+template<bool safe_mode>
+void AT24C256Async<safe_mode>::worker(void* arg)
+{
+    AT24C256Async<safe_mode>& self = *static_cast<AT24C256Async<safe_mode>*>(arg);
+    Request request;
+
+    while(true)
+    {
+        xQueueReceive(self._queue, &request, portMAX_DELAY);
+
+        bool result = false;
+
+        switch(request.operation)
+        {
+            case Operation::write:
+                result = self._eeprom.write(request.address, request.buffer, request.size);
+                break;
+
+            case Operation::read:
+                result = self._eeprom.read(request.address, request.buffer, request.size);
+                break;
+
+            case Operation::barrier:
+                xSemaphoreGive(self._idle);
+                continue;
+
+            case Operation::stop:
+                xSemaphoreGive(self._stopped);
+                vTaskDelete(nullptr);
+                return;
+        }
+
+        ESP_LOGD("AT24C256Async::worker", "Operation on %zu bytes @ 0x%04x done: %d", request.size, request.address, result);
+
+        if(request.callback)
+            request.callback(result, request.user_data);
+    }
+}
+
+template class AT24C256Async<true>;
+template class AT24C256Async<false>;
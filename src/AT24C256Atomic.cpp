@@ -0,0 +1,211 @@
+#include "AT24C256LogLevel.hpp"
+#include "AT24C256Atomic.hpp"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+#include "esp_rom_crc.h"
+
+template<bool safe_mode>
+AT24C256Atomic<safe_mode>::AT24C256Atomic(const AT24C256<safe_mode>& eeprom, uint16_t first_page, uint16_t page_count) 
+    : _eeprom(eeprom), _first_page(first_page), _page_count(page_count)
+{
+    if constexpr (safe_mode)
+    {
+        if(page_count == 0 || page_count > MAX_PAGES || first_page + 1 + 2 * page_count > PAGE_COUNT)
+        {
+            ESP_LOGE("AT24C256Atomic::AT24C256Atomic", "Invalid region: %u pages from page %u", page_count, first_page);
+            _page_count = 0;
+        }
+    }
+}
+
+template<bool safe_mode>
+bool AT24C256Atomic<safe_mode>::mount()
+{
+    _mounted = false;
+
+    if constexpr (safe_mode)
+    {
+        if(_page_count == 0)
+            return false;
+    }
+
+    std::array<CommitRecord, 2> slots;
+
+    if(!_eeprom.read(_first_page * PAGE_SIZE, (uint8_t*) slots.data(), PAGE_SIZE))
+        return false;
+
+    // Newest valid slot, a torn one being ignored
+    const CommitRecord* last = nullptr;
+
+    for(const CommitRecord& slot : slots)
+    {
+        if(crc(slot) != slot.crc)
+            continue;
+
+        if(!last || (int32_t)(slot.sequence - last->sequence) > 0)
+            last = &slot;
+    }
+
+    _current.reset();
+    _staged.reset();
+    _sequence = 0;
+
+    if(last)
+    {
+        _sequence = last->sequence;
+
+        for(uint16_t page = 0; page < _page_count; ++page)
+            _current[page] = last->copies[page / 8] & (1 << (page % 8));
+    }
+
+    ESP_LOGD("AT24C256Atomic::mount", "Last commit: %" PRIu32, _sequence);
+
+    _mounted = true;
+
+    return true;
+}
+
+template<bool safe_mode>
+bool AT24C256Atomic<safe_mode>::write(uint16_t address, const uint8_t* buffer, uint16_t size)
+{
+    if(!check_range("AT24C256Atomic::write", address, size))
+        return false;
+
+    while(size > 0)
+    {
+        uint16_t page = address / PAGE_SIZE;
+        uint16_t offset = address % PAGE_SIZE;
+        uint16_t count = std::min<uint16_t>(size, PAGE_SIZE - offset);
+
+        bool staged = !_current[page];
+
+        if(_staged[page] || count == PAGE_SIZE)
+        {
+            // The staged copy already holds the rest of the page, or nothing else is needed
+            if(!_eeprom.write_page(this->address(page, staged) + offset, (uint8_t*) buffer, count))
+                return false;
+        }
+        else
+        {
+            // First write to the page in this transaction: start from the current copy
+            std::array<uint8_t, PAGE_SIZE> data;
+
+            if(!_eeprom.read(this->address(page, _current[page]), data.data(), PAGE_SIZE))
+                return false;
+
+            std::copy(buffer, buffer + count, data.begin() + offset);
+
+            if(!_eeprom.write_page(this->address(page, staged), data.data(), PAGE_SIZE))
+                return false;
+        }
+
+        _staged[page] = true;
+
+        address += count;
+        buffer += count;
+        size -= count;
+    }
+
+    return true;
+}
+
+template<bool safe_mode>
+bool AT24C256Atomic<safe_mode>::read(uint16_t address, uint8_t* buffer, uint16_t size) const
+{
+    if(!check_range("AT24C256Atomic::read", address, size))
+        return false;
+
+    while(size > 0)
+    {
+        uint16_t page = address / PAGE_SIZE;
+        uint16_t offset = address % PAGE_SIZE;
+        uint16_t count = std::min<uint16_t>(size, PAGE_SIZE - offset);
+
+        if(!_eeprom.read(this->address(page, visible_copy(page)) + offset, buffer, count))
+            return false;
+
+        address += count;
+        buffer += count;
+        size -= count;
+    }
+
+    return true;
+}
+
+template<bool safe_mode>
+bool AT24C256Atomic<safe_mode>::commit()
+{
+    if constexpr (safe_mode)
+    {
+        if(!_mounted)
+        {
+            ESP_LOGE("AT24C256Atomic::commit", "Region is not mounted");
+            return false;
+        }
+    }
+
+    if(!_staged.any())
+        return true;
+
+    std::bitset<MAX_PAGES> current = _current ^ _staged;
+
+    CommitRecord record{ .sequence = _sequence + 1, .copies = {}, .crc = 0 };
+
+    for(uint16_t page = 0; page < _page_count; ++page)
+    {
+        if(current[page])
+            record.copies[page / 8] |= 1 << (page % 8);
+    }
+
+    record.crc = crc(record);
+
+    // The slot not holding the last commit
+    uint16_t slot = record.sequence % 2;
+
+    ESP_LOGD("AT24C256Atomic::commit", "Commit %" PRIu32 ": %zu pages, slot %u", record.sequence, _staged.count(), slot);
+
+    if(!_eeprom.write_page(_first_page * PAGE_SIZE + slot * SLOT_SIZE, (uint8_t*) &record, SLOT_SIZE))
+        return false;
+
+    // A commit is durable once its write cycle is over
+    if(!_eeprom.wait_ready())
+        return false;
+
+    _sequence = record.sequence;
+    _current = current;
+    _staged.reset();
+
+    return true;
+}
+
+template<bool safe_mode>
+bool AT24C256Atomic<safe_mode>::check_range(const char* tag, uint16_t address, uint16_t size) const
+{
+    if constexpr (safe_mode)
+    {
+        if(!_mounted)
+        {
+            ESP_LOGE(tag, "Region is not mounted");
+            return false;
+        }
+
+        if(address + size > this->size())
+        {
+            ESP_LOGE(tag, "Address 0x%04x + %u bytes is too big (region size: %u)", address, size, this->size());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+template<bool safe_mode>
+uint32_t AT24C256Atomic<safe_mode>::crc(const CommitRecord& record)
+{
+    return esp_rom_crc32_le(0, (const uint8_t*) &record, offsetof(CommitRecord, crc));
+}
+
+template class AT24C256Atomic<true>;
+template class AT24C256Atomic<false>;
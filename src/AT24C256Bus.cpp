@@ -0,0 +1,288 @@
+#include "AT24C256LogLevel.hpp"
+#include "AT24C256Bus.hpp"
+
+#include <algorithm>
+#include <bitset>
+
+template<bool safe_mode>
+AT24C256Bus<safe_mode>::AT24C256Bus(size_t queue_depth, UBaseType_t priority, uint32_t stack_size)
+{
+    _queue = xQueueCreate(queue_depth, sizeof(Request));
+    _idle = xSemaphoreCreateBinary();
+    _stopped = xSemaphoreCreateBinary();
+
+    if(!_queue || !_idle || !_stopped)
+    {
+        ESP_LOGE("AT24C256Bus::AT24C256Bus", "Could not allocate the queue (depth: %zu)", queue_depth);
+        ESP_ERROR_CHECK(ESP_ERR_NO_MEM);
+    }
+
+    if(xTaskCreate(task, "AT24C256Bus", stack_size, this, priority, nullptr) != pdPASS)
+    {
+        ESP_LOGE("AT24C256Bus::AT24C256Bus", "Could not create the scheduler task");
+        ESP_ERROR_CHECK(ESP_ERR_NO_MEM);
+    }
+}
+
+template<bool safe_mode>
+AT24C256Bus<safe_mode>::~AT24C256Bus()
+{
+    enqueue({ .operation = Operation::stop }, portMAX_DELAY);
+    xSemaphoreTake(_stopped, portMAX_DELAY);
+
+    vQueueDelete(_queue);
+    vSemaphoreDelete(_idle);
+    vSemaphoreDelete(_stopped);
+}
+
+template<bool safe_mode>
+std::optional<size_t> AT24C256Bus<safe_mode>::attach(const AT24C256<safe_mode>& eeprom)
+{
+    if(_device_count == MAX_DEVICES)
+    {
+        ESP_LOGE("AT24C256Bus::attach", "%zu devices are registered already", MAX_DEVICES);
+        return std::nullopt;
+    }
+
+    _devices[_device_count] = &eeprom;
+
+    return _device_count++;
+}
+
+template<bool safe_mode>
+bool AT24C256Bus<safe_mode>::write_async(size_t device, uint16_t address, std::span<const uint8_t> data, Callback callback, void* user_data)
+{
+    if(!check("AT24C256Bus::write_async", device, address, data.size()))
+        return false;
+
+    return enqueue({
+        .operation = Operation::write,
+        .device = (uint8_t) device,
+        .address = address,
+        .buffer = const_cast<uint8_t*>(data.data()),  // Writes do not modify the buffer
+        .size = data.size(),
+        .callback = callback,
+        .user_data = user_data
+    }, 0);
+}
+
+template<bool safe_mode>
+bool AT24C256Bus<safe_mode>::read_async(size_t device, uint16_t address, std::span<uint8_t> buffer, Callback callback, void* user_data)
+{
+    if(!check("AT24C256Bus::read_async", device, address, buffer.size()))
+        return false;
+
+    return enqueue({
+        .operation = Operation::read,
+        .device = (uint8_t) device,
+        .address = address,
+        .buffer = buffer.data(),
+        .size = buffer.size(),
+        .callback = callback,
+        .user_data = user_data
+    }, 0);
+}
+
+template<bool safe_mode>
+bool AT24C256Bus<safe_mode>::wait_idle(TickType_t timeout)
+{
+    // Drop a token left by a barrier that previously timed out
+    xSemaphoreTake(_idle, 0);
+
+    TickType_t start = xTaskGetTickCount();
+
+    if(!enqueue({ .operation = Operation::barrier }, timeout))
+        return false;
+
+    TickType_t elapsed = xTaskGetTickCount() - start;
+    TickType_t remaining = (timeout == portMAX_DELAY) ? portMAX_DELAY : (timeout > elapsed ? timeout - elapsed : 0);
+
+    return xSemaphoreTake(_idle, remaining) == pdTRUE;
+}
+
+template<bool safe_mode>
+bool AT24C256Bus<safe_mode>::enqueue(const Request& request, TickType_t timeout)
+{
+    if(xQueueSend(_queue, &request, timeout) != pdTRUE)
+    {
+        ESP_LOGD("AT24C256Bus::enqueue", "Queue is full");
+        return false;
+    }
+
+    return true;
+}
+
+template<bool safe_mode>
+bool AT24C256Bus<safe_mode>::check(const char* tag, size_t device, uint16_t address, size_t size) const
+{
+    // Checked even without safe_mode: the task indexes the devices with it
+    if(device >= _device_count) [[unlikely]]
+    {
+        ESP_LOGE(tag, "Unknown device %zu (%zu registered)", device, _device_count);
+        return false;
+    }
+
+    if constexpr (safe_mode)
+    {
+        if(address + size > AT24C256<safe_mode>::MEMORY_SIZE)
+        {
+            ESP_LOGE(tag, "Invalid operation on %zu bytes @ 0x%04x", size, address);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+template<bool safe_mode>
+bool AT24C256Bus<safe_mode>::schedule()
+{
+    // A barrier waits for everything queued before it, including write cycles
+    if(_pending[0].operation == Operation::barrier)
+    {
+        for(size_t i = 0; i < _device_count; ++i)
+            _devices[i]->wait_ready();
+
+        xSemaphoreGive(_idle);
+        complete(0, true);
+
+        return true;
+    }
+
+    // First operation of each device, and whether its chip is idle:
+    // probed once per pass
+    std::array<size_t, MAX_DEVICES> head;
+    std::bitset<MAX_DEVICES> has_work;
+    std::bitset<MAX_DEVICES> idle;
+
+    for(size_t i = 0; i < _pending_count; ++i)
+    {
+        const Request& request = _pending[i];
+
+        if(request.operation == Operation::barrier || has_work[request.device])
+            continue;
+
+        has_work[request.device] = true;
+        head[request.device] = i;
+        idle[request.device] = !_devices[request.device]->busy();
+    }
+
+    std::bitset<MAX_PENDING> finished;
+    std::array<bool, MAX_PENDING> results;
+
+    // Reads first: they complete in a single transfer
+    for(size_t device = 0; device < _device_count; ++device)
+    {
+        if(!has_work[device] || !idle[device] || _pending[head[device]].operation != Operation::read)
+            continue;
+
+        Request& request = _pending[head[device]];
+
+        finished[head[device]] = true;
+        results[head[device]] = _devices[device]->read_unchecked(request.address, request.buffer, request.size);
+    }
+
+    // Then a page of each write, its chip programming it while the others are served
+    for(size_t device = 0; device < _device_count; ++device)
+    {
+        if(!has_work[device] || !idle[device] || _pending[head[device]].operation != Operation::write)
+            continue;
+
+        bool success = true;
+
+        if(write_page(_pending[head[device]], success))
+        {
+            finished[head[device]] = true;
+            results[head[device]] = success;
+        }
+    }
+
+    bool progressed = (idle & has_work).any();
+
+    // From the last one, indices of the first ones stay valid
+    for(size_t i = _pending_count; i-- > 0; )
+    {
+        if(finished[i])
+            complete(i, results[i]);
+    }
+
+    return progressed;
+}
+
+template<bool safe_mode>
+bool AT24C256Bus<safe_mode>::write_page(Request& request, bool& success)
+{
+    if(request.done == request.size)
+        return true;
+
+    constexpr int PAGE_SIZE = AT24C256<safe_mode>::PAGE_SIZE;
+
+    uint16_t address = request.address + request.done;
+    size_t count = std::min<size_t>(request.size - request.done, PAGE_SIZE - address % PAGE_SIZE);
+
+    success = _devices[request.device]->write_page_unchecked(address, request.buffer + request.done, count);
+    request.done += count;
+
+    return !success || request.done == request.size;
+}
+
+template<bool safe_mode>
+void AT24C256Bus<safe_mode>::complete(size_t index, bool success)
+{
+    Request request = _pending[index];
+
+    std::move(_pending.begin() + index + 1, _pending.begin() + _pending_count, _pending.begin() + index);
+    _pending_count--;
+
+    if(request.operation == Operation::barrier)
+        return;
+
+    ESP_LOGD("AT24C256Bus::complete", "Operation on %zu bytes @ 0x%04x of device %u done: %d", request.size, request.address, request.device, success);
+
+    if(request.callback)
+        request.callback(success, request.user_data);
+}
+
+template<bool safe_mode>
+void AT24C256Bus<safe_mode>::task(void* arg)
+{
+    AT24C256Bus<safe_mode>& self = *static_cast<AT24C256Bus<safe_mode>*>(arg);
+    bool stopping = false;
+
+    while(true)
+    {
+        // Block on the queue only with nothing to schedule
+        TickType_t wait = (self._pending_count == 0) ? portMAX_DELAY : 0;
+        Request request;
+
+        while(!stopping && self._pending_count < MAX_PENDING && xQueueReceive(self._queue, &request, wait) == pdTRUE)
+        {
+            wait = 0;
+
+            if(request.operation == Operation::stop)
+                stopping = true;
+            else
+                self._pending[self._pending_count++] = request;
+        }
+
+        if(self._pending_count == 0)
+        {
+            if(!stopping)
+                continue;
+
+            xSemaphoreGive(self._stopped);
+            vTaskDelete(nullptr);
+            return;
+        }
+
+        // Every chip with work is busy: wait for the one of the oldest operation
+        if(!self.schedule())
+        {
+            const Request& oldest = self._pending[0];
+            self._devices[oldest.device]->wait_ready();
+        }
+    }
+}
+
+template class AT24C256Bus<true>;
+template class AT24C256Bus<false>;
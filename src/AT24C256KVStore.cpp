@@ -0,0 +1,475 @@
+#include "AT24C256LogLevel.hpp"
+#include "AT24C256KVStore.hpp"
+
+#include <cinttypes>
+#include <cstring>
+#include "esp_rom_crc.h"
+
+template<bool safe_mode>
+AT24C256KVStore<safe_mode>::AT24C256KVStore(const AT24C256<safe_mode>& eeprom, uint16_t first_page, uint16_t page_count) 
+    : _eeprom(eeprom), _first_page(first_page), _page_count(page_count)
+{
+    if constexpr (safe_mode)
+    {
+        if(page_count < MIN_PAGE_COUNT || first_page + page_count > PAGE_COUNT)
+        {
+            ESP_LOGE("AT24C256KVStore::AT24C256KVStore", "Invalid page range: %u pages from page %u", page_count, first_page);
+            _page_count = 0;
+        }
+    }
+
+    _tail.header = { .sequence = 1, .live_pages = 0, .used = 0, .reserved = 0, .crc = 0 };
+}
+
+template<bool safe_mode>
+AT24C256KVStore<safe_mode>::~AT24C256KVStore()
+{
+    if(_mounted && !flush())
+    {
+        ESP_LOGE("AT24C256KVStore::~AT24C256KVStore", "Updates were lost");
+    }
+}
+
+template<bool safe_mode>
+bool AT24C256KVStore<safe_mode>::format()
+{
+    _mounted = false;
+
+    if constexpr (safe_mode)
+    {
+        if(_page_count == 0)
+            return false;
+    }
+
+    // A header with an out of range used size is never valid
+    std::array<uint8_t, HEADER_SIZE> erased;
+    erased.fill(0xFF);
+
+    for(uint16_t index = 0; index < _page_count; ++index)
+    {
+        if(!_eeprom.write_page(address(index), erased.data(), erased.size()))
+            return false;
+    }
+
+    return mount();
+}
+
+template<bool safe_mode>
+bool AT24C256KVStore<safe_mode>::mount()
+{
+    _mounted = false;
+
+    if constexpr (safe_mode)
+    {
+        if(_page_count == 0)
+            return false;
+    }
+
+    Page page;
+
+    _index.fill({});
+    _tail.header = { .sequence = 1, .live_pages = 0, .used = 0, .reserved = 0, .crc = 0 };
+    _tail_index = 0;
+    _oldest = 0;
+
+    PageStatus status = read_page(0, page);
+
+    if(status == PageStatus::bus_error)
+    {
+        ESP_LOGE("AT24C256KVStore::mount", "Could not read page 0");
+        return false;
+    }
+
+    uint16_t low = 0;
+    uint32_t head_sequence = page.header.sequence;
+    uint16_t live_pages = page.header.live_pages;
+
+    // Newest page: same search as AT24C256Log, pages are written in turn.
+    // An invalid page 0 can't tell where the lap started: read every page
+    bool searched = (status == PageStatus::valid);
+
+    if(searched)
+    {
+        uint32_t first_sequence = page.header.sequence;
+        uint16_t high = _page_count;
+
+        while(high - low > 1)
+        {
+            uint16_t middle = (low + high) / 2;
+
+            status = read_page(middle, page);
+
+            if(status == PageStatus::bus_error)
+            {
+                ESP_LOGE("AT24C256KVStore::mount", "Could not read page %u", middle);
+                return false;
+            }
+
+            // Unused (first lap) or torn (the newest page only): not newer
+            if(status == PageStatus::valid && (int32_t)(page.header.sequence - first_sequence) > 0)
+            {
+                low = middle;
+                head_sequence = page.header.sequence;
+                live_pages = page.header.live_pages;
+            }
+            else
+            {
+                high = middle;
+            }
+        }
+    }
+
+    if(!searched)
+    {
+        // Unused range, or a torn or corrupted page 0
+        std::optional<uint16_t> newest;
+
+        if(!scan(newest, page.header))
+            return false;
+
+        if(!newest)
+        {
+            ESP_LOGD("AT24C256KVStore::mount", "Empty store");
+            _mounted = true;
+            return true;
+        }
+
+        low = *newest;
+        head_sequence = page.header.sequence;
+        live_pages = page.header.live_pages;
+    }
+
+    if(live_pages == 0 || live_pages >= _page_count) [[unlikely]]
+    {
+        ESP_LOGE("AT24C256KVStore::mount", "Corrupted page %u: %u live pages", low, live_pages);
+        return false;
+    }
+
+    _tail.header.sequence = head_sequence + 1;
+    _tail_index = (low + 1) % _page_count;
+    _oldest = (_tail_index + _page_count - live_pages) % _page_count;
+
+    // Replay the live pages, oldest first: the last record of a key wins
+    for(uint16_t i = 0; i < live_pages; ++i)
+    {
+        uint16_t index = (_oldest + i) % _page_count;
+
+        status = read_page(index, page);
+
+        if(status == PageStatus::bus_error)
+        {
+            ESP_LOGE("AT24C256KVStore::mount", "Could not read page %u", index);
+            return false;
+        }
+
+        // Skipping it would bring back the keys it removed
+        if(status == PageStatus::invalid)
+        {
+            ESP_LOGE("AT24C256KVStore::mount", "Corrupted live page %u", index);
+            _index.fill({});
+            return false;
+        }
+
+        for(uint16_t offset = 0; offset + RECORD_HEADER_SIZE <= page.header.used; )
+        {
+            uint8_t key = page.payload[offset];
+            uint8_t size = page.payload[offset + 1];
+
+            if(size == TOMBSTONE)
+            {
+                _index[key] = {};
+                offset += RECORD_HEADER_SIZE;
+                continue;
+            }
+
+            if(offset + RECORD_HEADER_SIZE + size > page.header.used) [[unlikely]]
+                break;
+
+            _index[key] = { .page = index, .offset = (uint8_t) offset, .size = size };
+            offset += RECORD_HEADER_SIZE + size;
+        }
+    }
+
+    _mounted = true;
+
+    ESP_LOGD("AT24C256KVStore::mount", "Newest page: %u (sequence %" PRIu32 "), %u live pages", low, head_sequence, live_pages);
+
+    return true;
+}
+
+template<bool safe_mode>
+bool AT24C256KVStore<safe_mode>::put(uint8_t key, const uint8_t* data, size_t size)
+{
+    if constexpr (safe_mode)
+    {
+        if(!_mounted)
+        {
+            ESP_LOGE("AT24C256KVStore::put", "Store is not mounted");
+            return false;
+        }
+
+        if(size > MAX_VALUE_SIZE)
+        {
+            ESP_LOGE("AT24C256KVStore::put", "Value of %zu bytes is too big (max: %d)", size, MAX_VALUE_SIZE);
+            return false;
+        }
+    }
+
+    // Writing the page being filled needs a free page, and compacting needs another one
+    if(!compact(2))
+        return false;
+
+    return append(key, data, size);
+}
+
+template<bool safe_mode>
+bool AT24C256KVStore<safe_mode>::get(uint8_t key, uint8_t* buffer, size_t size) const
+{
+    if constexpr (safe_mode)
+    {
+        if(!_mounted)
+        {
+            ESP_LOGE("AT24C256KVStore::get", "Store is not mounted");
+            return false;
+        }
+    }
+
+    const Location& location = _index[key];
+
+    if(location.page == NONE)
+        return false;
+
+    if(size != location.size)
+    {
+        ESP_LOGE("AT24C256KVStore::get", "Key %u: size mismatch (%zu, stored: %u)", key, size, location.size);
+        return false;
+    }
+
+    uint16_t offset = location.offset + RECORD_HEADER_SIZE;
+
+    // Not written yet
+    if(location.page == _tail_index)
+    {
+        std::memcpy(buffer, _tail.payload.data() + offset, size);
+        return true;
+    }
+
+    return _eeprom.read(address(location.page) + HEADER_SIZE + offset, buffer, size);
+}
+
+template<bool safe_mode>
+bool AT24C256KVStore<safe_mode>::remove(uint8_t key)
+{
+    if constexpr (safe_mode)
+    {
+        if(!_mounted)
+        {
+            ESP_LOGE("AT24C256KVStore::remove", "Store is not mounted");
+            return false;
+        }
+    }
+
+    if(!contains(key))
+        return true;
+
+    if(!compact(2))
+        return false;
+
+    return append(key, nullptr, TOMBSTONE);
+}
+
+template<bool safe_mode>
+bool AT24C256KVStore<safe_mode>::flush()
+{
+    if(_tail.header.used == 0)
+        return true;
+
+    return write_tail();
+}
+
+template<bool safe_mode>
+bool AT24C256KVStore<safe_mode>::compact(uint16_t min_free_pages)
+{
+    if constexpr (safe_mode)
+    {
+        if(!_mounted)
+        {
+            ESP_LOGE("AT24C256KVStore::compact", "Store is not mounted");
+            return false;
+        }
+    }
+
+    // Once every page was compacted, the live values are as packed as they can be
+    for(uint16_t remaining = used_pages(); free_pages() < min_free_pages; --remaining)
+    {
+        if(remaining == 0)
+        {
+            ESP_LOGE("AT24C256KVStore::compact", "Store is full");
+            return false;
+        }
+
+        if(!compact_oldest())
+            return false;
+    }
+
+    return true;
+}
+
+template<bool safe_mode>
+bool AT24C256KVStore<safe_mode>::append(uint8_t key, const uint8_t* data, uint8_t size)
+{
+    uint8_t data_size = size == TOMBSTONE ? 0 : size;
+
+    if(_tail.header.used + RECORD_HEADER_SIZE + data_size > PAYLOAD_SIZE)
+    {
+        if(!write_tail())
+            return false;
+    }
+
+    uint8_t offset = _tail.header.used;
+    uint8_t* record = _tail.payload.data() + offset;
+    record[0] = key;
+    record[1] = size;
+    std::memcpy(record + RECORD_HEADER_SIZE, data, data_size);
+
+    _tail.header.used += RECORD_HEADER_SIZE + data_size;
+
+    if(size == TOMBSTONE)
+        _index[key] = {};
+    else
+        _index[key] = { .page = _tail_index, .offset = offset, .size = size };
+
+    return true;
+}
+
+template<bool safe_mode>
+bool AT24C256KVStore<safe_mode>::write_tail()
+{
+    if(free_pages() == 0) [[unlikely]]
+    {
+        ESP_LOGE("AT24C256KVStore::write_tail", "No free page");
+        return false;
+    }
+
+    // The header tells mount() where the live pages start
+    _tail.header.live_pages = used_pages() + 1;
+    _tail.header.crc = crc(_tail);
+
+    ESP_LOGD("AT24C256KVStore::write_tail", "Writing page %u (sequence %" PRIu32 ", %u bytes)", _tail_index, _tail.header.sequence, _tail.header.used);
+
+    if(!_eeprom.write_page(address(_tail_index), (uint8_t*) &_tail, HEADER_SIZE + _tail.header.used))
+        return false;
+
+    _tail.header.sequence++;
+    _tail.header.used = 0;
+    _tail_index = (_tail_index + 1) % _page_count;
+
+    return true;
+}
+
+template<bool safe_mode>
+bool AT24C256KVStore<safe_mode>::compact_oldest()
+{
+    if(used_pages() == 0)
+        return true;
+
+    Page page;
+    uint16_t index = _oldest;
+
+    if(read_page(index, page) != PageStatus::valid)
+    {
+        // Can't be skipped while it holds live values: the bus may only be busy
+        for(const Location& location : _index)
+        {
+            if(location.page == index)
+            {
+                ESP_LOGE("AT24C256KVStore::compact_oldest", "Can't read page %u", index);
+                return false;
+            }
+        }
+    }
+    else
+    {
+        for(uint16_t offset = 0; offset + RECORD_HEADER_SIZE <= page.header.used; )
+        {
+            uint8_t key = page.payload[offset];
+            uint8_t size = page.payload[offset + 1];
+            uint8_t data_size = size == TOMBSTONE ? 0 : size;
+
+            if(offset + RECORD_HEADER_SIZE + data_size > page.header.used) [[unlikely]]
+                break;
+
+            // Superseded records and tombstones are dropped: the older records
+            // of their key are in pages freed before this one
+            const Location& location = _index[key];
+
+            if(location.page == index && location.offset == offset)
+            {
+                if(!append(key, page.payload.data() + offset + RECORD_HEADER_SIZE, size))
+                    return false;
+            }
+
+            offset += RECORD_HEADER_SIZE + data_size;
+        }
+    }
+
+    // Written to the chip with the next page: until then, mount() still replays this one
+    _oldest = (_oldest + 1) % _page_count;
+
+    return true;
+}
+
+template<bool safe_mode>
+typename AT24C256KVStore<safe_mode>::PageStatus AT24C256KVStore<safe_mode>::read_page(uint16_t index, Page& page) const
+{
+    // Header first, then only the used part of the payload
+    if(!_eeprom.read(address(index), (uint8_t*) &page.header, HEADER_SIZE))
+        return PageStatus::bus_error;
+
+    if(page.header.used > PAYLOAD_SIZE)
+        return PageStatus::invalid;
+
+    if(page.header.used > 0 && !_eeprom.read(address(index) + HEADER_SIZE, page.payload.data(), page.header.used))
+        return PageStatus::bus_error;
+
+    return (crc(page) == page.header.crc) ? PageStatus::valid : PageStatus::invalid;
+}
+
+template<bool safe_mode>
+bool AT24C256KVStore<safe_mode>::scan(std::optional<uint16_t>& newest, Header& header) const
+{
+    Page page;
+
+    newest.reset();
+
+    for(uint16_t index = 0; index < _page_count; ++index)
+    {
+        PageStatus status = read_page(index, page);
+
+        if(status == PageStatus::bus_error)
+        {
+            ESP_LOGE("AT24C256KVStore::scan", "Could not read page %u", index);
+            return false;
+        }
+
+        if(status == PageStatus::valid && (!newest || (int32_t)(page.header.sequence - header.sequence) > 0))
+        {
+            newest = index;
+            header = page.header;
+        }
+    }
+
+    return true;
+}
+
+template<bool safe_mode>
+uint16_t AT24C256KVStore<safe_mode>::crc(const Page& page)
+{
+    // Header without its CRC field, then the used payload
+    uint16_t crc = esp_rom_crc16_le(0, (const uint8_t*) &page.header, offsetof(Header, crc));
+
+    return esp_rom_crc16_le(crc, page.payload.data(), page.header.used);
+}
+
+template class AT24C256KVStore<true>;
+template class AT24C256KVStore<false>;
@@ -0,0 +1,286 @@
+#include "AT24C256LogLevel.hpp"
+#include "AT24C256Log.hpp"
+
+#include <cinttypes>
+#include <cstring>
+#include "esp_rom_crc.h"
+
+template<bool safe_mode>
+AT24C256Log<safe_mode>::AT24C256Log(const AT24C256<safe_mode>& eeprom, uint16_t first_page, uint16_t page_count) 
+    : _eeprom(eeprom), _first_page(first_page), _page_count(page_count)
+{
+    if constexpr (safe_mode)
+    {
+        if(page_count < 2 || first_page + page_count > PAGE_COUNT)
+        {
+            ESP_LOGE("AT24C256Log::AT24C256Log", "Invalid page range: %u pages from page %u", page_count, first_page);
+            _page_count = 0;
+        }
+    }
+
+    _tail.header = { .sequence = 1, .used = 0, .reserved = 0, .crc = 0 };
+}
+
+template<bool safe_mode>
+AT24C256Log<safe_mode>::~AT24C256Log()
+{
+    if(_mounted && !flush())
+    {
+        ESP_LOGE("AT24C256Log::~AT24C256Log", "Records were lost");
+    }
+}
+
+template<bool safe_mode>
+bool AT24C256Log<safe_mode>::mount()
+{
+    _mounted = false;
+
+    if constexpr (safe_mode)
+    {
+        if(_page_count == 0)
+            return false;
+    }
+
+    Page page;
+
+    _tail.header = { .sequence = 1, .used = 0, .reserved = 0, .crc = 0 };
+    _tail_index = 0;
+
+    PageStatus status = read_page(0, page);
+
+    if(status == PageStatus::bus_error)
+    {
+        ESP_LOGE("AT24C256Log::mount", "Could not read page 0");
+        return false;
+    }
+
+    if(status == PageStatus::invalid)
+    {
+        // Unused range, or page 0 torn while the log wrapped around
+        std::optional<uint16_t> newest;
+        uint32_t sequence = 0;
+
+        if(!scan(newest, sequence))
+            return false;
+
+        if(newest)
+        {
+            _tail.header.sequence = sequence + 1;
+            _tail_index = (*newest + 1) % _page_count;
+        }
+
+        _mounted = true;
+
+        ESP_LOGD("AT24C256Log::mount", "Page 0 is not valid, newest page: %d", newest ? *newest : -1);
+
+        return true;
+    }
+
+    uint32_t first_sequence = page.header.sequence;
+    uint32_t head_sequence = first_sequence;
+
+    // Pages written after page 0 (in the current lap) have a greater sequence number,
+    // the others are either unused or older: find the last one of the first kind
+    uint16_t low = 0;
+    uint16_t high = _page_count;
+
+    while(high - low > 1)
+    {
+        uint16_t middle = (low + high) / 2;
+
+        status = read_page(middle, page);
+
+        if(status == PageStatus::bus_error)
+        {
+            ESP_LOGE("AT24C256Log::mount", "Could not read page %u", middle);
+            return false;
+        }
+
+        if(status == PageStatus::valid && (int32_t)(page.header.sequence - first_sequence) > 0)
+        {
+            low = middle;
+            head_sequence = page.header.sequence;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    _tail.header.sequence = head_sequence + 1;
+    _tail_index = (low + 1) % _page_count;
+    _mounted = true;
+
+    ESP_LOGD("AT24C256Log::mount", "Newest page: %u (sequence %" PRIu32 ")", low, head_sequence);
+
+    return true;
+}
+
+template<bool safe_mode>
+bool AT24C256Log<safe_mode>::append(const uint8_t* data, size_t size)
+{
+    if constexpr (safe_mode)
+    {
+        if(!_mounted)
+        {
+            ESP_LOGE("AT24C256Log::append", "Log is not mounted");
+            return false;
+        }
+
+        if(size > MAX_RECORD_SIZE)
+        {
+            ESP_LOGE("AT24C256Log::append", "Record of %zu bytes is too big (max: %d)", size, MAX_RECORD_SIZE);
+            return false;
+        }
+    }
+
+    if(_tail.header.used + 1 + size > PAYLOAD_SIZE)
+    {
+        if(!flush())
+            return false;
+    }
+
+    uint8_t* record = _tail.payload.data() + _tail.header.used;
+    record[0] = size;
+    std::memcpy(record + 1, data, size);
+
+    _tail.header.used += 1 + size;
+
+    // Full page: no need to wait for the next record
+    if(_tail.header.used == PAYLOAD_SIZE)
+        return flush();
+
+    return true;
+}
+
+template<bool safe_mode>
+bool AT24C256Log<safe_mode>::flush()
+{
+    if(_tail.header.used == 0)
+        return true;
+
+    _tail.header.crc = crc(_tail);
+
+    ESP_LOGD("AT24C256Log::flush", "Writing page %u (sequence %" PRIu32 ", %u bytes)", _tail_index, _tail.header.sequence, _tail.header.used);
+
+    if(!_eeprom.write_page(address(_tail_index), (uint8_t*) &_tail, HEADER_SIZE + _tail.header.used))
+        return false;
+
+    _tail.header.sequence++;
+    _tail.header.used = 0;
+    _tail_index = (_tail_index + 1) % _page_count;
+
+    return true;
+}
+
+template<bool safe_mode>
+bool AT24C256Log<safe_mode>::for_each(RecordConsumer consumer, void* user_data) const
+{
+    if constexpr (safe_mode)
+    {
+        if(!_mounted)
+        {
+            ESP_LOGE("AT24C256Log::for_each", "Log is not mounted");
+            return false;
+        }
+    }
+
+    auto consume = [&](const Page& page) {
+        for(uint16_t offset = 0; offset < page.header.used; )
+        {
+            uint8_t size = page.payload[offset];
+
+            if(offset + 1 + size > page.header.used) [[unlikely]]
+                return true;
+
+            if(!consumer(page.payload.data() + offset + 1, size, user_data))
+                return false;
+
+            offset += 1 + size;
+        }
+
+        return true;
+    };
+
+    // Oldest page first: the one after the tail, unused and torn pages being skipped
+    Page page;
+
+    for(uint16_t i = 1; i < _page_count; ++i)
+    {
+        uint16_t index = (_tail_index + i) % _page_count;
+
+        PageStatus status = read_page(index, page);
+
+        if(status == PageStatus::bus_error)
+            return false;
+
+        if(status == PageStatus::invalid)
+            continue;
+
+        // Leftovers of a previous log in the range are not part of this one
+        if((int32_t)(page.header.sequence - _tail.header.sequence) >= 0)
+            continue;
+
+        if(!consume(page))
+            return true;
+    }
+
+    consume(_tail);
+
+    return true;
+}
+
+template<bool safe_mode>
+typename AT24C256Log<safe_mode>::PageStatus AT24C256Log<safe_mode>::read_page(uint16_t index, Page& page) const
+{
+    // Header first, then only the used part of the payload
+    if(!_eeprom.read(address(index), (uint8_t*) &page.header, HEADER_SIZE))
+        return PageStatus::bus_error;
+
+    if(page.header.used > PAYLOAD_SIZE)
+        return PageStatus::invalid;
+
+    if(page.header.used > 0 && !_eeprom.read(address(index) + HEADER_SIZE, page.payload.data(), page.header.used))
+        return PageStatus::bus_error;
+
+    return (crc(page) == page.header.crc) ? PageStatus::valid : PageStatus::invalid;
+}
+
+template<bool safe_mode>
+bool AT24C256Log<safe_mode>::scan(std::optional<uint16_t>& newest, uint32_t& sequence) const
+{
+    Page page;
+
+    newest.reset();
+
+    for(uint16_t index = 0; index < _page_count; ++index)
+    {
+        PageStatus status = read_page(index, page);
+
+        if(status == PageStatus::bus_error)
+        {
+            ESP_LOGE("AT24C256Log::scan", "Could not read page %u", index);
+            return false;
+        }
+
+        if(status == PageStatus::valid && (!newest || (int32_t)(page.header.sequence - sequence) > 0))
+        {
+            newest = index;
+            sequence = page.header.sequence;
+        }
+    }
+
+    return true;
+}
+
+template<bool safe_mode>
+uint16_t AT24C256Log<safe_mode>::crc(const Page& page)
+{
+    // Header without its CRC field, then the used payload
+    uint16_t crc = esp_rom_crc16_le(0, (const uint8_t*) &page.header, offsetof(Header, crc));
+
+    return esp_rom_crc16_le(crc, page.payload.data(), page.header.used);
+}
+
+template class AT24C256Log<true>;
+template class AT24C256Log<false>;
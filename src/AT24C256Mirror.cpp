@@ -0,0 +1,251 @@
+#include "AT24C256LogLevel.hpp"
+#include "AT24C256Mirror.hpp"
+
+#include <array>
+#include "esp_heap_caps.h"
+
+template<bool safe_mode>
+AT24C256Mirror<safe_mode>::AT24C256Mirror(const AT24C256<safe_mode>& eeprom, uint32_t sync_delay_ms, UBaseType_t priority, uint32_t stack_size) : _eeprom(eeprom), _sync_delay_ms(sync_delay_ms)
+{
+    // PSRAM first: 32 KB of internal RAM is a lot to give up
+    _memory = (uint8_t*) heap_caps_malloc(MEMORY_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+
+    if(!_memory)
+        _memory = (uint8_t*) heap_caps_malloc(MEMORY_SIZE, MALLOC_CAP_8BIT);
+
+    _lock = xSemaphoreCreateMutex();
+    _bus = xSemaphoreCreateMutex();
+    _sync = xSemaphoreCreateMutex();
+    _wake = xSemaphoreCreateBinary();
+    _stopped = xSemaphoreCreateBinary();
+
+    if(!_memory || !_lock || !_bus || !_sync || !_wake || !_stopped)
+    {
+        ESP_LOGE("AT24C256Mirror::AT24C256Mirror", "Could not allocate the mirror (%d bytes)", MEMORY_SIZE);
+        ESP_ERROR_CHECK(ESP_ERR_NO_MEM);
+    }
+
+    if(xTaskCreate(sync_task, "AT24C256Mirror", stack_size, this, priority, nullptr) != pdPASS)
+    {
+        ESP_LOGE("AT24C256Mirror::AT24C256Mirror", "Could not create the sync task");
+        ESP_ERROR_CHECK(ESP_ERR_NO_MEM);
+    }
+}
+
+template<bool safe_mode>
+AT24C256Mirror<safe_mode>::~AT24C256Mirror()
+{
+    _stop = true;
+    xSemaphoreGive(_wake);
+    xSemaphoreTake(_stopped, portMAX_DELAY);
+
+    if(!flush())
+        ESP_LOGE("AT24C256Mirror::~AT24C256Mirror", "Some dirty pages could not be written back");
+
+    heap_caps_free(_memory);
+    vSemaphoreDelete(_lock);
+    vSemaphoreDelete(_bus);
+    vSemaphoreDelete(_sync);
+    vSemaphoreDelete(_wake);
+    vSemaphoreDelete(_stopped);
+}
+
+template<bool safe_mode>
+std::span<const uint8_t> AT24C256Mirror<safe_mode>::view(uint16_t address, size_t size)
+{
+    if constexpr (safe_mode)
+    {
+        if(address + size > MEMORY_SIZE)
+        {
+            ESP_LOGE("AT24C256Mirror::view", "Invalid view of %zu bytes @ 0x%04x", size, address);
+            return {};
+        }
+    }
+
+    if(!load(address, size))
+        return {};
+
+    return { _memory + address, size };
+}
+
+template<bool safe_mode>
+bool AT24C256Mirror<safe_mode>::write(uint16_t address, const uint8_t* buffer, size_t size)
+{
+    if constexpr (safe_mode)
+    {
+        if(address + size > MEMORY_SIZE)
+        {
+            ESP_LOGE("AT24C256Mirror::write", "Invalid write of %zu bytes @ 0x%04x", size, address);
+            return false;
+        }
+    }
+
+    if(size == 0)
+        return true;
+
+    // Only the first and last pages can be partially written
+    size_t end = address + size;
+
+    if(address % PAGE_SIZE && !load(address, 1))
+        return false;
+
+    if(end % PAGE_SIZE && !load(end - 1, 1))
+        return false;
+
+    xSemaphoreTake(_lock, portMAX_DELAY);
+
+    std::memcpy(_memory + address, buffer, size);
+
+    for(size_t page = address / PAGE_SIZE; page <= (end - 1) / PAGE_SIZE; ++page)
+    {
+        _loaded[page] = true;
+        _dirty[page] = true;
+    }
+
+    xSemaphoreGive(_lock);
+
+    xSemaphoreGive(_wake);
+
+    return true;
+}
+
+template<bool safe_mode>
+bool AT24C256Mirror<safe_mode>::flush()
+{
+    return sync();
+}
+
+template<bool safe_mode>
+bool AT24C256Mirror<safe_mode>::pending() const
+{
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    bool result = _dirty.any();
+    xSemaphoreGive(_lock);
+
+    return result;
+}
+
+template<bool safe_mode>
+bool AT24C256Mirror<safe_mode>::load(uint16_t address, size_t size)
+{
+    if(size == 0)
+        return true;
+
+    size_t first = address / PAGE_SIZE;
+    size_t last = (address + size - 1) / PAGE_SIZE;
+
+    for(size_t page = first; page <= last; )
+    {
+        if(_loaded[page])
+        {
+            ++page;
+            continue;
+        }
+
+        size_t count = 1;
+
+        while(page + count <= last && !_loaded[page + count])
+            ++count;
+
+        // Unloaded pages are never dirty, the sync task does not touch them
+        xSemaphoreTake(_bus, portMAX_DELAY);
+        bool result = _eeprom.read_chunked(page * PAGE_SIZE, _memory + page * PAGE_SIZE, count * PAGE_SIZE);
+        xSemaphoreGive(_bus);
+
+        if(!result)
+        {
+            ESP_LOGE("AT24C256Mirror::load", "Could not load %zu pages from page %zu", count, page);
+            return false;
+        }
+
+        for(size_t i = 0; i < count; ++i)
+            _loaded[page + i] = true;
+
+        page += count;
+    }
+
+    return true;
+}
+
+template<bool safe_mode>
+bool AT24C256Mirror<safe_mode>::sync()
+{
+    std::array<uint8_t, PAGE_SIZE> page_data;
+    bool result = true;
+
+    // A page copied and cleared by another pass may not be on the chip yet
+    xSemaphoreTake(_sync, portMAX_DELAY);
+
+    for(size_t page = 0; page < PAGE_COUNT; ++page)
+    {
+        xSemaphoreTake(_lock, portMAX_DELAY);
+
+        bool dirty = _dirty[page];
+
+        // Cleared before writing: a write during the transfer dirties the page again
+        if(dirty)
+        {
+            std::memcpy(page_data.data(), _memory + page * PAGE_SIZE, PAGE_SIZE);
+            _dirty[page] = false;
+        }
+
+        xSemaphoreGive(_lock);
+
+        if(!dirty)
+            continue;
+
+        xSemaphoreTake(_bus, portMAX_DELAY);
+        bool written = _eeprom.write_page(page * PAGE_SIZE, page_data.data(), PAGE_SIZE);
+        xSemaphoreGive(_bus);
+
+        if(!written)
+        {
+            ESP_LOGW("AT24C256Mirror::sync", "Could not write page %zu back", page);
+
+            xSemaphoreTake(_lock, portMAX_DELAY);
+            _dirty[page] = true;
+            xSemaphoreGive(_lock);
+
+            result = false;
+        }
+    }
+
+    xSemaphoreTake(_bus, portMAX_DELAY);
+    result &= _eeprom.wait_ready();
+    xSemaphoreGive(_bus);
+
+    xSemaphoreGive(_sync);
+
+    return result;
+}
+
+template<bool safe_mode>
+void AT24C256Mirror<safe_mode>::sync_task(void* arg)
+{
+    AT24C256Mirror<safe_mode>& self = *static_cast<AT24C256Mirror<safe_mode>*>(arg);
+
+    while(true)
+    {
+        xSemaphoreTake(self._wake, portMAX_DELAY);
+
+        if(self._stop)
+            break;
+
+        // Let a burst of writes land before writing pages back
+        vTaskDelay(pdMS_TO_TICKS(self._sync_delay_ms));
+
+        // Wake-ups given during the delay are covered by this pass
+        xSemaphoreTake(self._wake, 0);
+
+        if(self._stop)
+            break;
+
+        self.sync();
+    }
+
+    xSemaphoreGive(self._stopped);
+    vTaskDelete(nullptr);
+}
+
+template class AT24C256Mirror<true>;
+template class AT24C256Mirror<false>;
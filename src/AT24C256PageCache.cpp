@@ -0,0 +1,239 @@
+#include "AT24C256LogLevel.hpp"
+#include "AT24C256PageCache.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+template<bool safe_mode>
+AT24C256PageCache<safe_mode>::AT24C256PageCache(const AT24C256<safe_mode>& eeprom, size_t capacity) : _eeprom(eeprom), _entries(capacity)
+{
+    ESP_LOGD("AT24C256PageCache::AT24C256PageCache", "Caching %zu pages", capacity);
+}
+
+template<bool safe_mode>
+AT24C256PageCache<safe_mode>::~AT24C256PageCache()
+{
+    if(!flush())
+    {
+        ESP_LOGE("AT24C256PageCache::~AT24C256PageCache", "Dirty pages were lost");
+    }
+}
+
+template<bool safe_mode>
+bool AT24C256PageCache<safe_mode>::write(uint16_t address, const uint8_t* buffer, uint16_t size)
+{
+    if constexpr (safe_mode)
+    {
+        if((address+size) > MEMORY_SIZE)
+        {
+            ESP_LOGE("AT24C256PageCache::write", "Address 0x%04x + %u bytes is too big (max address: 0x%04x)", address, size, MEMORY_SIZE-1);
+            return false;
+        }
+    }
+
+    uint32_t current_addr = address;
+    uint32_t end_addr = address + size;
+
+    while(current_addr < end_addr)
+    {
+        uint16_t page = current_addr / PAGE_SIZE;
+        uint16_t offset = current_addr % PAGE_SIZE;
+        uint16_t byte_count = std::min<uint32_t>(PAGE_SIZE - offset, end_addr - current_addr);
+
+        Entry* entry = find(page);
+
+        if(!entry)
+        {
+            // A page written as a whole does not need its previous content
+            entry = load(page, byte_count != PAGE_SIZE);
+
+            if(!entry)
+            {
+                ESP_LOGE("AT24C256PageCache::write", "Could not cache page %u", page);
+                return false;
+            }
+        }
+
+        std::memcpy(entry->data.data() + offset, buffer, byte_count);
+
+        for(uint16_t i=offset; i<offset+byte_count; ++i)
+        {
+            entry->dirty.set(i);
+        }
+
+        entry->last_use = ++_clock;
+
+        current_addr += byte_count;
+        buffer += byte_count;
+    }
+
+    return true;
+}
+
+template<bool safe_mode>
+bool AT24C256PageCache<safe_mode>::read(uint16_t address, uint8_t* buffer, size_t size)
+{
+    if constexpr (safe_mode)
+    {
+        if((address+size) > MEMORY_SIZE)
+        {
+            ESP_LOGE("AT24C256PageCache::read", "Address 0x%04x + %zu bytes is too big (max address: 0x%04x)", address, size, MEMORY_SIZE-1);
+            return false;
+        }
+    }
+
+    uint32_t current_addr = address;
+    uint32_t end_addr = address + size;
+
+    // Consecutive non-resident pages are read from the chip in a single transfer
+    uint32_t miss_addr = current_addr;
+    uint8_t* miss_buffer = buffer;
+    size_t miss_size = 0;
+
+    while(current_addr < end_addr)
+    {
+        uint16_t page = current_addr / PAGE_SIZE;
+        uint16_t offset = current_addr % PAGE_SIZE;
+        uint16_t byte_count = std::min<uint32_t>(PAGE_SIZE - offset, end_addr - current_addr);
+
+        Entry* entry = find(page);
+
+        if(entry)
+        {
+            if(miss_size > 0)
+            {
+                if(!_eeprom.read(miss_addr, miss_buffer, miss_size))
+                    return false;
+
+                miss_size = 0;
+            }
+
+            std::memcpy(buffer, entry->data.data() + offset, byte_count);
+            entry->last_use = ++_clock;
+        }
+        else
+        {
+            if(miss_size == 0)
+            {
+                miss_addr = current_addr;
+                miss_buffer = buffer;
+            }
+
+            miss_size += byte_count;
+        }
+
+        current_addr += byte_count;
+        buffer += byte_count;
+    }
+
+    if(miss_size > 0)
+        return _eeprom.read(miss_addr, miss_buffer, miss_size);
+
+    return true;
+}
+
+template<bool safe_mode>
+bool AT24C256PageCache<safe_mode>::flush()
+{
+    bool result = true;
+
+    for(Entry& entry : _entries)
+    {
+        if(entry.valid && entry.dirty.any())
+        {
+            result &= write_back(entry);
+        }
+    }
+
+    return result;
+}
+
+template<bool safe_mode>
+void AT24C256PageCache<safe_mode>::invalidate()
+{
+    for(Entry& entry : _entries)
+    {
+        entry.valid = false;
+        entry.dirty.reset();
+    }
+}
+
+template<bool safe_mode>
+auto AT24C256PageCache<safe_mode>::find(uint16_t page) -> Entry*
+{
+    for(Entry& entry : _entries)
+    {
+        if(entry.valid && entry.page == page)
+            return &entry;
+    }
+
+    return nullptr;
+}
+
+template<bool safe_mode>
+auto AT24C256PageCache<safe_mode>::load(uint16_t page, bool fetch) -> Entry*
+{
+    if(_entries.empty()) [[unlikely]]
+        return nullptr;
+
+    // Free slot first, least recently used otherwise
+    Entry* victim = &_entries.front();
+
+    for(Entry& entry : _entries)
+    {
+        if(!entry.valid)
+        {
+            victim = &entry;
+            break;
+        }
+
+        if(entry.last_use < victim->last_use)
+            victim = &entry;
+    }
+
+    if(victim->valid && victim->dirty.any())
+    {
+        ESP_LOGD("AT24C256PageCache::load", "Evicting dirty page %u", victim->page);
+
+        if(!write_back(*victim))
+            return nullptr;
+    }
+
+    victim->valid = false;
+
+    if(fetch && !_eeprom.read(page * PAGE_SIZE, victim->data.data(), PAGE_SIZE))
+        return nullptr;
+
+    victim->valid = true;
+    victim->page = page;
+    victim->dirty.reset();
+    victim->last_use = ++_clock;
+
+    return victim;
+}
+
+template<bool safe_mode>
+bool AT24C256PageCache<safe_mode>::write_back(Entry& entry)
+{
+    uint16_t first = 0;
+    while(!entry.dirty.test(first))
+        ++first;
+
+    uint16_t last = PAGE_SIZE - 1;
+    while(!entry.dirty.test(last))
+        --last;
+
+    // The whole page is resident: clean bytes between two dirty ones are
+    // rewritten with their current value to keep a single write cycle
+    ESP_LOGD("AT24C256PageCache::write_back", "Page %u: bytes %u to %u", entry.page, first, last);
+
+    if(!_eeprom.write_page(entry.page * PAGE_SIZE + first, entry.data.data() + first, last - first + 1))
+        return false;
+
+    entry.dirty.reset();
+
+    return true;
+}
+
+template class AT24C256PageCache<true>;
+template class AT24C256PageCache<false>;
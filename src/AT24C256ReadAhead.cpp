@@ -0,0 +1,84 @@
+#include "AT24C256LogLevel.hpp"
+#include "AT24C256ReadAhead.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+template<bool safe_mode>
+AT24C256ReadAhead<safe_mode>::AT24C256ReadAhead(const AT24C256<safe_mode>& eeprom, size_t window) : _eeprom(eeprom), _window(window)
+{
+    ESP_LOGD("AT24C256ReadAhead::AT24C256ReadAhead", "Reading ahead %zu bytes", window);
+}
+
+template<bool safe_mode>
+bool AT24C256ReadAhead<safe_mode>::read(uint16_t address, uint8_t* buffer, size_t size)
+{
+    if constexpr (safe_mode)
+    {
+        if(address + size > MEMORY_SIZE)
+        {
+            ESP_LOGE("AT24C256ReadAhead::read", "Invalid read of %zu bytes @ 0x%04x", size, address);
+            return false;
+        }
+    }
+
+    bool sequential = (address == _next);
+    _next = address + size;
+
+    // Hit
+    if(address >= _start && address + size <= _start + _size)
+    {
+        std::memcpy(buffer, _window.data() + (address - _start), size);
+        return true;
+    }
+
+    // Random access, too big to be worth buffering, or looping back to 0x0000
+    // (unsafe mode): the window would hold less than size bytes
+    if(!sequential || size >= _window.size() || address + size > MEMORY_SIZE)
+        return _eeprom.read_unchecked(address, buffer, size);
+
+    size_t count = std::min<size_t>(_window.size(), MEMORY_SIZE - address);
+
+    if(!_eeprom.read_unchecked(address, _window.data(), count))
+    {
+        invalidate();
+        return false;
+    }
+
+    ESP_LOGD("AT24C256ReadAhead::read", "Fetched %zu bytes @ 0x%04x", count, address);
+
+    _start = address;
+    _size = count;
+
+    std::memcpy(buffer, _window.data(), size);
+
+    return true;
+}
+
+template<bool safe_mode>
+bool AT24C256ReadAhead<safe_mode>::write(uint16_t address, const uint8_t* buffer, uint16_t size)
+{
+    // write() does not modify the buffer
+    if(!_eeprom.write(address, const_cast<uint8_t*>(buffer), size))
+    {
+        invalidate();
+        return false;
+    }
+
+    uint32_t first = std::max<uint32_t>(address, _start);
+    uint32_t last = std::min<uint32_t>(address + size, _start + _size);
+
+    if(first < last)
+        std::memcpy(_window.data() + (first - _start), buffer + (first - address), last - first);
+
+    return true;
+}
+
+template<bool safe_mode>
+void AT24C256ReadAhead<safe_mode>::invalidate()
+{
+    _size = 0;
+}
+
+template class AT24C256ReadAhead<true>;
+template class AT24C256ReadAhead<false>;
@@ -0,0 +1,214 @@
+#include "AT24C256LogLevel.hpp"
+#include "AT24C256Shared.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+template<bool safe_mode>
+AT24C256Shared<safe_mode>::AT24C256Shared(const AT24C256<safe_mode>& eeprom) : _eeprom(eeprom)
+{
+    _mutex = xSemaphoreCreateMutex();
+
+    if(!_mutex)
+    {
+        ESP_LOGE("AT24C256Shared::AT24C256Shared", "Could not allocate the mutex");
+        ESP_ERROR_CHECK(ESP_ERR_NO_MEM);
+    }
+}
+
+template<bool safe_mode>
+AT24C256Shared<safe_mode>::~AT24C256Shared()
+{
+    vSemaphoreDelete(_mutex);
+}
+
+template<bool safe_mode>
+bool AT24C256Shared<safe_mode>::write(uint16_t address, const uint8_t* buffer, uint16_t size)
+{
+    if constexpr (safe_mode)
+    {
+        if((address+size) > MEMORY_SIZE)
+        {
+            ESP_LOGE("AT24C256Shared::write", "Address 0x%04x + %u bytes is too big (max address: 0x%04x)", address, size, MEMORY_SIZE-1);
+            return false;
+        }
+    }
+
+    Request request{ .write = true, .address = address, .buffer = const_cast<uint8_t*>(buffer), .size = size };
+
+    return submit(request);
+}
+
+template<bool safe_mode>
+bool AT24C256Shared<safe_mode>::read(uint16_t address, uint8_t* buffer, size_t size)
+{
+    if constexpr (safe_mode)
+    {
+        if((address+size) > MEMORY_SIZE)
+        {
+            ESP_LOGE("AT24C256Shared::read", "Address 0x%04x + %zu bytes is too big (max address: 0x%04x)", address, size, MEMORY_SIZE-1);
+            return false;
+        }
+    }
+
+    Request request{ .write = false, .address = address, .buffer = buffer, .size = size };
+
+    return submit(request);
+}
+
+template<bool safe_mode>
+bool AT24C256Shared<safe_mode>::submit(Request& request)
+{
+    taskENTER_CRITICAL(&_spinlock);
+    request.next = _pending;
+    _pending = &request;
+    taskEXIT_CRITICAL(&_spinlock);
+
+    Lock lock(_mutex);
+
+    // The previous mutex holder may have already executed the request
+    if(!request.done)
+        combine();
+
+    return request.result;
+}
+
+template<bool safe_mode>
+void AT24C256Shared<safe_mode>::combine()
+{
+    taskENTER_CRITICAL(&_spinlock);
+    Request* pending = _pending;
+    _pending = nullptr;
+    taskEXIT_CRITICAL(&_spinlock);
+
+    // Stable insertion sort by address, from the oldest request to the most recent one.
+    // A request is never moved before an older one it overlaps, if either writes:
+    // overlapping requests run in arrival order, the others in address order
+    Request* fifo = nullptr;
+
+    while(pending)
+    {
+        Request* next = pending->next;
+        pending->next = fifo;
+        fifo = pending;
+        pending = next;
+    }
+
+    Request* sorted = nullptr;
+    size_t count = 0;
+
+    while(fifo)
+    {
+        Request* next = fifo->next;
+
+        Request** slot = &sorted;
+
+        for(Request** other = &sorted; *other; other = &(*other)->next)
+        {
+            if(conflicts(**other, *fifo))
+                slot = &(*other)->next;
+        }
+
+        while(*slot && (*slot)->address <= fifo->address)
+            slot = &(*slot)->next;
+
+        fifo->next = *slot;
+        *slot = fifo;
+
+        fifo = next;
+        ++count;
+    }
+
+    ESP_LOGD("AT24C256Shared::combine", "Executing %zu requests", count);
+
+    // Contiguous writes into the same page are merged in a staging buffer,
+    // [staged_begin, staged_end[ being the bytes written by requests group to staged_last
+    std::array<uint8_t, PAGE_SIZE> staging;
+    int staged_page = -1;
+    uint16_t staged_begin = 0;
+    uint16_t staged_end = 0;
+    Request* group = nullptr;
+    Request* staged_last = nullptr;
+
+    auto flush_staging = [&]() {
+        if(staged_page < 0)
+            return;
+
+        // Through write() for config.skip_unchanged and config.verify_writes
+        bool result = _eeprom.write(staged_page * PAGE_SIZE + staged_begin, staging.data() + staged_begin, staged_end - staged_begin);
+
+        if(!result)
+        {
+            for(Request* r = group; r != staged_last->next; r = r->next)
+            {
+                if(r->write)
+                    r->result = false;
+            }
+        }
+
+        staged_page = -1;
+    };
+
+    for(Request* request = sorted; request; request = request->next)
+    {
+        if(!request->write)
+        {
+            // The writes sorted before it must be on the chip, staged page included
+            flush_staging();
+
+            request->result = _eeprom.read(request->address, request->buffer, request->size);
+            continue;
+        }
+
+        uint32_t current_addr = request->address;
+        uint32_t end_addr = request->address + request->size;
+        const uint8_t* current_buffer = request->buffer;
+
+        while(current_addr < end_addr)
+        {
+            int page = current_addr / PAGE_SIZE;
+            uint16_t offset = current_addr % PAGE_SIZE;
+            uint16_t byte_count = std::min<uint32_t>(PAGE_SIZE - offset, end_addr - current_addr);
+
+            bool contiguous = (page == staged_page) && (offset >= staged_begin) && (offset <= staged_end);
+
+            if(!contiguous)
+            {
+                flush_staging();
+
+                staged_page = page;
+                staged_begin = offset;
+                staged_end = offset;
+                group = request;
+            }
+
+            std::memcpy(staging.data() + offset, current_buffer, byte_count);
+            staged_end = std::max<uint16_t>(staged_end, offset + byte_count);
+            staged_last = request;
+
+            current_addr += byte_count;
+            current_buffer += byte_count;
+        }
+    }
+
+    flush_staging();
+
+    // Requesting tasks can only see this once the mutex is released
+    for(Request* request = sorted; request; request = request->next)
+    {
+        request->done = true;
+    }
+}
+
+template<bool safe_mode>
+bool AT24C256Shared<safe_mode>::conflicts(const Request& a, const Request& b)
+{
+    if(!a.write && !b.write)
+        return false;
+
+    return a.address < b.address + b.size && b.address < a.address + a.size;
+}
+
+template class AT24C256Shared<true>;
+template class AT24C256Shared<false>;
@@ -0,0 +1,435 @@
+#include "AT24C256LogLevel.hpp"
+#include "AT24C256WriteBehind.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+template<bool safe_mode>
+AT24C256WriteBehind<safe_mode>::AT24C256WriteBehind(const AT24C256<safe_mode>& eeprom, UBaseType_t priority) : AT24C256WriteBehind(eeprom, { .priority = priority })
+{
+}
+
+template<bool safe_mode>
+AT24C256WriteBehind<safe_mode>::AT24C256WriteBehind(const AT24C256<safe_mode>& eeprom, const AT24C256WriteBehindConfig& config) : _eeprom(eeprom), _config(config)
+{
+    _lock = xSemaphoreCreateMutexStatic(&_lock_buffer);
+    _bus = xSemaphoreCreateMutexStatic(&_bus_buffer);
+    _wake = xSemaphoreCreateBinaryStatic(&_wake_buffer);
+    _drained = xSemaphoreCreateBinaryStatic(&_drained_buffer);
+    _stopped = xSemaphoreCreateBinaryStatic(&_stopped_buffer);
+    _write_cycle_done = xSemaphoreCreateBinaryStatic(&_write_cycle_done_buffer);
+
+    if(_config.write_cycle_sleep_us > 0)
+    {
+        esp_timer_create_args_t timer_args = {
+            .callback = write_cycle_timer_callback,
+            .arg = this,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "AT24C256WB",
+            .skip_unhandled_events = false,
+        };
+
+        ESP_ERROR_CHECK(esp_timer_create(&timer_args, &_write_cycle_timer));
+    }
+
+#if CONFIG_PM_ENABLE
+    ESP_ERROR_CHECK(esp_pm_lock_create(ESP_PM_APB_FREQ_MAX, 0, "AT24C256WB", &_pm_lock));
+#endif
+
+    _task = xTaskCreateStatic(drain_task, "AT24C256WB", STACK_SIZE, this, _config.priority, _stack.data(), &_task_buffer);
+
+    if(!_task)
+    {
+        ESP_LOGE("AT24C256WriteBehind::AT24C256WriteBehind", "Could not create the drain task");
+        ESP_ERROR_CHECK(ESP_ERR_INVALID_STATE);
+    }
+}
+
+template<bool safe_mode>
+AT24C256WriteBehind<safe_mode>::~AT24C256WriteBehind()
+{
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    _stop = true;
+    xSemaphoreGive(_lock);
+
+    xSemaphoreGive(_wake);
+    xSemaphoreTake(_stopped, portMAX_DELAY);
+
+    // The task runs on a stack of the object: delete it once it is parked
+    while(eTaskGetState(_task) != eSuspended)
+        vTaskDelay(1);
+
+    vTaskDelete(_task);
+
+    if(_write_cycle_timer)
+        esp_timer_delete(_write_cycle_timer);
+
+#if CONFIG_PM_ENABLE
+    esp_pm_lock_delete(_pm_lock);
+#endif
+
+    vSemaphoreDelete(_lock);
+    vSemaphoreDelete(_bus);
+    vSemaphoreDelete(_wake);
+    vSemaphoreDelete(_drained);
+    vSemaphoreDelete(_stopped);
+    vSemaphoreDelete(_write_cycle_done);
+}
+
+template<bool safe_mode>
+bool AT24C256WriteBehind<safe_mode>::write(uint16_t address, const uint8_t* buffer, size_t size)
+{
+    if constexpr (safe_mode)
+    {
+        if(address + size > AT24C256<safe_mode>::MEMORY_SIZE)
+        {
+            ESP_LOGE("AT24C256WriteBehind::write", "Invalid write of %zu bytes @ 0x%04x", size, address);
+            return false;
+        }
+    }
+
+    if(size == 0)
+        return true;
+
+    uint16_t first_page = address / PAGE_SIZE;
+    uint16_t last_page = (address + size - 1) / PAGE_SIZE;
+
+    xSemaphoreTake(_lock, portMAX_DELAY);
+
+    size_t needed = 0;
+
+    for(uint16_t page = first_page; page <= last_page; ++page)
+        needed += (find(page) == nullptr);
+
+    if(_count + needed > SLOT_COUNT)
+    {
+        xSemaphoreGive(_lock);
+
+        ESP_LOGD("AT24C256WriteBehind::write", "Queue is full (%zu slots needed)", needed);
+        return false;
+    }
+
+    size_t offset = 0;
+
+    for(uint16_t page = first_page; page <= last_page; ++page)
+    {
+        Slot* slot = find(page);
+
+        if(!slot)
+        {
+            slot = &_slots[(_tail + _count) % SLOT_COUNT];
+            slot->page = page;
+            slot->valid.reset();
+            ++_count;
+        }
+
+        size_t first = (address + offset) % PAGE_SIZE;
+        size_t count = std::min<size_t>(PAGE_SIZE - first, size - offset);
+
+        std::memcpy(slot->data.data() + first, buffer + offset, count);
+
+        for(size_t i = first; i < first + count; ++i)
+            slot->valid[i] = true;
+
+        offset += count;
+    }
+
+    xSemaphoreGive(_lock);
+
+    xSemaphoreGive(_wake);
+
+    return true;
+}
+
+template<bool safe_mode>
+bool AT24C256WriteBehind<safe_mode>::read(uint16_t address, uint8_t* buffer, size_t size)
+{
+    xSemaphoreTake(_bus, portMAX_DELAY);
+
+    // Slots still queued after the chip read are either not programmed yet,
+    // or hold the bytes just read: applying them in ring order is right either way
+    bool result = _eeprom.read(address, buffer, size);
+
+    if(result)
+    {
+        xSemaphoreTake(_lock, portMAX_DELAY);
+
+        for(size_t i = 0; i < _count; ++i)
+        {
+            const Slot& slot = _slots[(_tail + i) % SLOT_COUNT];
+
+            size_t page_address = slot.page * PAGE_SIZE;
+            size_t first = std::max<size_t>(page_address, address);
+            size_t last = std::min<size_t>(page_address + PAGE_SIZE, address + size);
+
+            for(size_t j = first; j < last; ++j)
+            {
+                if(slot.valid[j - page_address])
+                    buffer[j - address] = slot.data[j - page_address];
+            }
+        }
+
+        xSemaphoreGive(_lock);
+    }
+
+    xSemaphoreGive(_bus);
+
+    return result;
+}
+
+template<bool safe_mode>
+bool AT24C256WriteBehind<safe_mode>::flush(TickType_t timeout)
+{
+    // Drop a token left by a previous drain
+    xSemaphoreTake(_drained, 0);
+
+    // Only cleared by the drain of a batch: not raised on an empty queue
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    if(_count > 0)
+        _flush = true;
+    xSemaphoreGive(_lock);
+
+    TickType_t start = xTaskGetTickCount();
+
+    while(pending() > 0)
+    {
+        xSemaphoreGive(_wake);
+
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        TickType_t remaining = (timeout == portMAX_DELAY) ? portMAX_DELAY : (timeout > elapsed ? timeout - elapsed : 0);
+
+        // The token may predate writes queued since: check again
+        if(xSemaphoreTake(_drained, remaining) != pdTRUE)
+        {
+            ESP_LOGW("AT24C256WriteBehind::flush", "Timeout, %zu slots left", pending());
+            return false;
+        }
+    }
+
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    bool failed = _failed;
+    _failed = false;
+    xSemaphoreGive(_lock);
+
+    return !failed;
+}
+
+template<bool safe_mode>
+size_t AT24C256WriteBehind<safe_mode>::pending() const
+{
+    xSemaphoreTake(_lock, portMAX_DELAY);
+    size_t count = _count;
+    xSemaphoreGive(_lock);
+
+    return count;
+}
+
+template<bool safe_mode>
+typename AT24C256WriteBehind<safe_mode>::Slot* AT24C256WriteBehind<safe_mode>::find(uint16_t page)
+{
+    for(size_t i = _draining; i < _count; ++i)
+    {
+        Slot& slot = _slots[(_tail + i) % SLOT_COUNT];
+
+        if(slot.page == page)
+            return &slot;
+    }
+
+    return nullptr;
+}
+
+template<bool safe_mode>
+bool AT24C256WriteBehind<safe_mode>::program(Slot& slot)
+{
+    size_t first = 0;
+    size_t last = PAGE_SIZE;
+
+    while(!slot.valid[first])
+        ++first;
+
+    while(!slot.valid[last - 1])
+        --last;
+
+    uint16_t address = slot.page * PAGE_SIZE + first;
+    size_t size = last - first;
+
+    // Gaps between the queued writes: keep the bytes the chip holds
+    if((slot.valid >> first).count() != size)
+    {
+        std::array<uint8_t, PAGE_SIZE> current;
+
+        if(!_eeprom.read_unchecked(address, current.data(), size))
+            return false;
+
+        for(size_t i = first; i < last; ++i)
+        {
+            if(!slot.valid[i])
+                slot.data[i] = current[i - first];
+        }
+    }
+
+    return _eeprom.write_page_unchecked(address, slot.data.data() + first, size);
+}
+
+template<bool safe_mode>
+void AT24C256WriteBehind<safe_mode>::hold()
+{
+    if(_config.batch_deadline_ms == 0)
+        return;
+
+    TickType_t start = xTaskGetTickCount();
+    TickType_t deadline = pdMS_TO_TICKS(_config.batch_deadline_ms);
+
+    while(true)
+    {
+        xSemaphoreTake(_lock, portMAX_DELAY);
+        bool ready = (_count == 0) || (_count >= _config.batch_pages) || (_count == SLOT_COUNT) || _flush || _stop;
+        xSemaphoreGive(_lock);
+
+        TickType_t elapsed = xTaskGetTickCount() - start;
+
+        if(ready || elapsed >= deadline)
+            return;
+
+        // Woken up by each write, flush() and the destructor
+        xSemaphoreTake(_wake, deadline - elapsed);
+    }
+}
+
+template<bool safe_mode>
+void AT24C256WriteBehind<safe_mode>::sleep_write_cycle()
+{
+    if(!_write_cycle_timer || !_eeprom.busy())
+        return;
+
+    // Sub-tick sleep: the task blocks, the CPU idles
+    esp_err_t err = esp_timer_start_once(_write_cycle_timer, _config.write_cycle_sleep_us);
+
+    if(err != ESP_OK)
+    {
+        // Nothing would wake the task: ACK polling waits instead
+        ESP_LOGW("AT24C256WriteBehind::sleep_write_cycle", "Could not start the timer: [%u] %s", err, esp_err_to_name(err));
+        return;
+    }
+
+    pm_release();
+    xSemaphoreTake(_write_cycle_done, portMAX_DELAY);
+    pm_acquire();
+}
+
+template<bool safe_mode>
+void AT24C256WriteBehind<safe_mode>::pm_acquire()
+{
+#if CONFIG_PM_ENABLE
+    esp_pm_lock_acquire(_pm_lock);
+#endif
+}
+
+template<bool safe_mode>
+void AT24C256WriteBehind<safe_mode>::pm_release()
+{
+#if CONFIG_PM_ENABLE
+    esp_pm_lock_release(_pm_lock);
+#endif
+}
+
+template<bool safe_mode>
+void AT24C256WriteBehind<safe_mode>::write_cycle_timer_callback(void* arg)
+{
+    AT24C256WriteBehind<safe_mode>& self = *static_cast<AT24C256WriteBehind<safe_mode>*>(arg);
+
+    xSemaphoreGive(self._write_cycle_done);
+}
+
+template<bool safe_mode>
+void AT24C256WriteBehind<safe_mode>::drain_task(void* arg)
+{
+    AT24C256WriteBehind<safe_mode>& self = *static_cast<AT24C256WriteBehind<safe_mode>*>(arg);
+
+    while(true)
+    {
+        xSemaphoreTake(self._wake, portMAX_DELAY);
+
+        while(true)
+        {
+            self.hold();
+
+            xSemaphoreTake(self._lock, portMAX_DELAY);
+
+            size_t batch = self._count;
+            self._draining = batch;
+            bool stop = self._stop;
+
+            xSemaphoreGive(self._lock);
+
+            if(batch == 0)
+            {
+                if(stop)
+                {
+                    // Parked for the destructor to delete: the idle task
+                    // would clean the TCB up after the object is gone
+                    xSemaphoreGive(self._stopped);
+                    vTaskSuspend(nullptr);
+                    return;
+                }
+
+                break;
+            }
+
+            // Writers never touch the slots of the batch
+            std::array<size_t, SLOT_COUNT> order;
+
+            for(size_t i = 0; i < batch; ++i)
+                order[i] = (self._tail + i) % SLOT_COUNT;
+
+            std::sort(order.begin(), order.begin() + batch, [&](size_t a, size_t b) {
+                return self._slots[a].page < self._slots[b].page;
+            });
+
+            bool failed = false;
+
+            xSemaphoreTake(self._bus, portMAX_DELAY);
+
+            self.pm_acquire();
+
+            for(size_t i = 0; i < batch; ++i)
+            {
+                Slot& slot = self._slots[order[i]];
+
+                if(!self.program(slot))
+                {
+                    ESP_LOGE("AT24C256WriteBehind::drain_task", "Could not program page %u", slot.page);
+                    failed = true;
+                }
+
+                self.sleep_write_cycle();
+            }
+
+            failed |= !self._eeprom.wait_ready();
+
+            self.pm_release();
+
+            xSemaphoreGive(self._bus);
+
+            xSemaphoreTake(self._lock, portMAX_DELAY);
+
+            self._tail = (self._tail + batch) % SLOT_COUNT;
+            self._count -= batch;
+            self._draining = 0;
+            self._failed |= failed;
+
+            bool empty = (self._count == 0);
+
+            if(empty)
+                self._flush = false;
+
+            xSemaphoreGive(self._lock);
+
+            if(empty)
+                xSemaphoreGive(self._drained);
+        }
+    }
+}
+
+template class AT24C256WriteBehind<true>;
+template class AT24C256WriteBehind<false>;
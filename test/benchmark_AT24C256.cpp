@@ -0,0 +1,140 @@
+#include <algorithm>
+#include <array>
+#include <cinttypes>
+#include <stdio.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "driver/i2c_master.h"
+
+#include "AT24C256.hpp"
+
+/**
+ * Throughput and latency of every I/O path, for each bus speed and write completion mode
+ * 
+ * Each operation is timed with esp_timer_get_time(), and reported as
+ * min / median / p99 latency (microseconds) and sustained throughput
+ * (the latter includes the write cycles still pending at the end of the run).
+ * 
+ * Uses the chip @ 0x51 and overwrites addresses 0x4000 to 0x5FFF
+ */
+
+extern "C" {
+    void app_main(void);
+}
+
+static constexpr size_t MAX_ITERATIONS = 100;
+static constexpr size_t READ_ITERATIONS = 100;
+static constexpr size_t WRITE_ITERATIONS = 20;
+
+static constexpr uint16_t BASE_ADDRESS = 0x4000;
+
+static std::array<uint8_t, 4096> g_buffer;
+
+template<typename F>
+void bench(const char* name, const AT24C256<>& eeprom, size_t bytes_per_op, size_t iterations, F&& op)
+{
+    std::array<int64_t, MAX_ITERATIONS> samples;
+    size_t failures = 0;
+
+    iterations = std::min(iterations, MAX_ITERATIONS);
+
+    int64_t start = esp_timer_get_time();
+
+    for(size_t i=0; i<iterations; ++i)
+    {
+        int64_t op_start = esp_timer_get_time();
+
+        if(!op(i))
+            ++failures;
+
+        samples[i] = esp_timer_get_time() - op_start;
+    }
+
+    eeprom.wait_ready();
+
+    int64_t total = esp_timer_get_time() - start;
+
+    std::sort(samples.begin(), samples.begin() + iterations);
+
+    int64_t min = samples[0];
+    int64_t median = samples[iterations / 2];
+    int64_t p99 = samples[std::min(iterations - 1, (iterations * 99) / 100)];
+    double throughput = (double)(bytes_per_op * iterations) * 1000000.0 / total / 1024.0;
+
+    printf("  %-28s %9" PRId64 " %9" PRId64 " %9" PRId64 " %10.2f %s\n", name, min, median, p99, throughput, failures ? "FAILURES" : "");
+}
+
+void bench_device(uint32_t scl_speed_hz, AT24C256WriteCompletion write_completion, i2c_master_bus_handle_t bus)
+{
+    static constexpr const char* completion_names[] = { "fixed_delay", "ack_polling", "deferred" };
+
+    printf("\n%" PRIu32 " Hz, %s\n", scl_speed_hz, completion_names[(int)write_completion]);
+    printf("  %-28s %9s %9s %9s %10s\n", "operation", "min (us)", "med (us)", "p99 (us)", "KB/s");
+
+    AT24C256 eeprom(bus, 0x51, { .scl_speed_hz = scl_speed_hz, .write_completion = write_completion });
+
+    bench("write(byte)", eeprom, 1, WRITE_ITERATIONS, [&](size_t i) {
+        return eeprom.write(BASE_ADDRESS + i, (uint8_t) i);
+    });
+
+    bench("read(byte)", eeprom, 1, READ_ITERATIONS, [&](size_t i) {
+        return eeprom.read(BASE_ADDRESS + i).has_value();
+    });
+
+    bench("write_page(64)", eeprom, 64, WRITE_ITERATIONS, [&](size_t i) {
+        return eeprom.write_page(BASE_ADDRESS + i * 64, g_buffer.data(), 64);
+    });
+
+    bench("write(256) aligned", eeprom, 256, WRITE_ITERATIONS, [&](size_t i) {
+        return eeprom.write(BASE_ADDRESS + (i % 16) * 256, g_buffer.data(), 256);
+    });
+
+    bench("write(256) unaligned", eeprom, 256, WRITE_ITERATIONS, [&](size_t i) {
+        return eeprom.write(BASE_ADDRESS + 10 + (i % 16) * 256, g_buffer.data(), 256);
+    });
+
+    bench("read(4096)", eeprom, 4096, READ_ITERATIONS / 10, [&](size_t) {
+        return eeprom.read(BASE_ADDRESS, g_buffer.data(), 4096);
+    });
+
+    bench("read_chunked(4096, 256)", eeprom, 4096, READ_ITERATIONS / 10, [&](size_t) {
+        return eeprom.read_chunked(BASE_ADDRESS, g_buffer.data(), 4096, 256);
+    });
+}
+
+void app_main(void)
+{
+    esp_log_level_set("*", ESP_LOG_WARN);
+
+    i2c_master_bus_config_t i2c_mst_config = {
+        .i2c_port = -1,
+        .sda_io_num = GPIO_NUM_21,
+        .scl_io_num = GPIO_NUM_22,
+        .clk_source = I2C_CLK_SRC_DEFAULT,
+        .glitch_ignore_cnt = 7,
+        .intr_priority = 0,
+        .trans_queue_depth = 0,
+        .flags = { .enable_internal_pullup = true}
+    };
+
+    i2c_master_bus_handle_t bus_handle;
+    ESP_ERROR_CHECK(i2c_new_master_bus(&i2c_mst_config, &bus_handle));
+
+    for(size_t i=0; i<g_buffer.size(); ++i)
+    {
+        g_buffer[i] = i;
+    }
+
+    for(uint32_t scl_speed_hz : { AT24C256<>::I2C_MASTER_FREQ_HZ, AT24C256<>::I2C_MASTER_FREQ_HZ_FAST, AT24C256<>::I2C_MASTER_FREQ_HZ_MAX })
+    {
+        for(AT24C256WriteCompletion write_completion : { AT24C256WriteCompletion::fixed_delay, AT24C256WriteCompletion::ack_polling, AT24C256WriteCompletion::deferred })
+        {
+            bench_device(scl_speed_hz, write_completion, bus_handle);
+        }
+    }
+
+    ESP_ERROR_CHECK(i2c_del_master_bus(bus_handle));
+
+    printf("\nBenchmark done\n");
+}
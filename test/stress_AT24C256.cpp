@@ -0,0 +1,578 @@
+#include <algorithm>
+#include <array>
+#include <cinttypes>
+#include <cstring>
+#include <memory>
+#include <stdio.h>
+
+#include "esp_log.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+#include "driver/i2c_master.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "nvs_flash.h"
+
+#include "AT24C256.hpp"
+#include "AT24C256Async.hpp"
+#include "AT24C256PageCache.hpp"
+#include "AT24C256Shared.hpp"
+#include "AT24C256WriteBehind.hpp"
+
+/**
+ * Hardware in the loop stress and soak test
+ *
+ * For each access path (shared with ACK polling, shared with deferred write
+ * cycles, async worker, page cache, write-behind queue), TASK_COUNT tasks issue
+ * random reads and writes across the whole chip for DURATION_S seconds.
+ * Reads are checked against a RAM shadow of the chip, and the whole chip is
+ * checked against it at the end of each phase.
+ *
+ * Each phase reports its sustained throughput (bytes read and written) and
+ * its tail latencies, and fails if the throughput is more than
+ * TOLERANCE_PERCENT below the baseline recorded in NVS by the first run
+ * (or by a run built with -DAT24C256_STRESS_RECORD=1).
+ *
+ * Uses the chip @ 0x51 and overwrites all of it
+ */
+
+#ifndef AT24C256_STRESS_DURATION_S
+#define AT24C256_STRESS_DURATION_S 60
+#endif
+
+#ifndef AT24C256_STRESS_RECORD
+#define AT24C256_STRESS_RECORD 0
+#endif
+
+// 0: random seed, printed to reproduce a failing run
+#ifndef AT24C256_STRESS_SEED
+#define AT24C256_STRESS_SEED 0
+#endif
+
+extern "C" {
+    void app_main(void);
+}
+
+static constexpr size_t TASK_COUNT = 4;
+static constexpr int64_t DURATION_S = AT24C256_STRESS_DURATION_S;
+static constexpr uint32_t TOLERANCE_PERCENT = 10;
+
+// Most operations are small records, one in four spans up to MAX_OP_SIZE bytes
+static constexpr size_t SMALL_OP_SIZE = 16;
+static constexpr size_t MAX_OP_SIZE = 256;
+
+static constexpr size_t PAGE_CACHE_CAPACITY = 8;
+
+static constexpr size_t MEMORY_SIZE = AT24C256<>::MEMORY_SIZE;
+static constexpr int PAGE_SIZE = AT24C256<>::PAGE_SIZE;
+
+// Operations on overlapping pages are serialized with the shadow update
+static constexpr size_t STRIPE_COUNT = 16;
+
+static std::array<uint8_t, MEMORY_SIZE> g_shadow;
+static std::array<SemaphoreHandle_t, STRIPE_COUNT> g_stripes;
+
+using Histogram = AT24C256Stats::Histogram;
+
+struct PhaseResult
+{
+    Histogram read_latency;
+    Histogram write_latency;
+    uint64_t bytes = 0;
+    int64_t duration_us = 0;
+    uint32_t failures = 0;
+    uint32_t mismatches = 0;
+};
+
+template<typename Target>
+struct Worker
+{
+    Target* target;
+    uint32_t seed;
+    int64_t end_us;
+    SemaphoreHandle_t done;
+    PhaseResult result;
+};
+
+static uint32_t next_random(uint32_t& state)
+{
+    // xorshift32
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+static uint32_t lock_range(uint16_t address, size_t size)
+{
+    size_t first_page = address / PAGE_SIZE;
+    size_t last_page = (address + size - 1) / PAGE_SIZE;
+
+    uint32_t stripes = 0;
+
+    for(size_t page = first_page; page <= last_page && page < first_page + STRIPE_COUNT; ++page)
+        stripes |= 1u << (page % STRIPE_COUNT);
+
+    // Always in the same order: no deadlock
+    for(size_t i = 0; i < STRIPE_COUNT; ++i)
+    {
+        if(stripes & (1u << i))
+            xSemaphoreTake(g_stripes[i], portMAX_DELAY);
+    }
+
+    return stripes;
+}
+
+static void unlock_range(uint32_t stripes)
+{
+    for(size_t i = 0; i < STRIPE_COUNT; ++i)
+    {
+        if(stripes & (1u << i))
+            xSemaphoreGive(g_stripes[i]);
+    }
+}
+
+template<typename Target>
+static void worker_task(void* arg)
+{
+    Worker<Target>& worker = *static_cast<Worker<Target>*>(arg);
+    uint32_t state = worker.seed;
+
+    std::array<uint8_t, MAX_OP_SIZE> buffer;
+
+    while(esp_timer_get_time() < worker.end_us)
+    {
+        uint32_t r = next_random(state);
+
+        uint16_t address = next_random(state) % MEMORY_SIZE;
+        size_t size = 1 + next_random(state) % ((r & 3) == 0 ? MAX_OP_SIZE : SMALL_OP_SIZE);
+        size = std::min(size, MEMORY_SIZE - address);
+
+        bool is_write = (r >> 2) % 5 < 2;
+
+        if(is_write)
+        {
+            for(size_t i = 0; i < size; ++i)
+                buffer[i] = next_random(state);
+        }
+
+        uint32_t stripes = lock_range(address, size);
+
+        int64_t start = esp_timer_get_time();
+        bool success = is_write ? worker.target->write(address, buffer.data(), size) : worker.target->read(address, buffer.data(), size);
+        uint32_t latency = esp_timer_get_time() - start;
+
+        if(!success)
+        {
+            ++worker.result.failures;
+
+            // Unknown content after a failed write: resync the shadow
+            if(is_write)
+                worker.target->read(address, g_shadow.data() + address, size);
+        }
+        else if(is_write)
+        {
+            std::memcpy(g_shadow.data() + address, buffer.data(), size);
+        }
+        else if(std::memcmp(g_shadow.data() + address, buffer.data(), size) != 0)
+        {
+            ESP_LOGE("stress", "Read mismatch: %zu bytes @ 0x%04x", size, address);
+            ++worker.result.mismatches;
+        }
+
+        unlock_range(stripes);
+
+        if(success)
+        {
+            (is_write ? worker.result.write_latency : worker.result.read_latency).add(latency);
+            worker.result.bytes += size;
+        }
+    }
+
+    xSemaphoreGive(worker.done);
+    vTaskDelete(nullptr);
+}
+
+static void merge(Histogram& into, const Histogram& from)
+{
+    for(size_t i = 0; i < AT24C256Stats::BUCKET_COUNT; ++i)
+        into.buckets[i] += from.buckets[i];
+
+    into.count += from.count;
+    into.total_us += from.total_us;
+    into.max_us = std::max(into.max_us, from.max_us);
+}
+
+/**
+ * Upper bound of the latency under which per_mille of the operations fall
+ */
+static uint32_t percentile_us(const Histogram& histogram, uint32_t per_mille)
+{
+    uint64_t threshold = ((uint64_t) histogram.count * per_mille + 999) / 1000;
+    uint64_t cumulated = 0;
+
+    for(size_t i = 0; i < AT24C256Stats::BUCKET_LIMITS_US.size(); ++i)
+    {
+        cumulated += histogram.buckets[i];
+
+        if(cumulated >= threshold)
+            return std::min(AT24C256Stats::BUCKET_LIMITS_US[i], histogram.max_us);
+    }
+
+    return histogram.max_us;
+}
+
+template<typename Target>
+PhaseResult run_phase(Target& target, uint32_t seed)
+{
+    std::array<Worker<Target>, TASK_COUNT> workers;
+    SemaphoreHandle_t done = xSemaphoreCreateCounting(TASK_COUNT, 0);
+
+    int64_t start = esp_timer_get_time();
+
+    for(size_t i = 0; i < TASK_COUNT; ++i)
+    {
+        workers[i] = { &target, seed + (uint32_t) i * 0x9E3779B9u, start + DURATION_S * 1000000, done, {} };
+
+        if(workers[i].seed == 0)
+            workers[i].seed = 1;
+
+        xTaskCreate(worker_task<Target>, "stress", 4096, &workers[i], 5, nullptr);
+    }
+
+    for(size_t i = 0; i < TASK_COUNT; ++i)
+        xSemaphoreTake(done, portMAX_DELAY);
+
+    vSemaphoreDelete(done);
+
+    PhaseResult result;
+
+    // Writes still queued or cached count in the duration
+    if(!target.finish())
+        ++result.failures;
+
+    result.duration_us = esp_timer_get_time() - start;
+
+    for(const Worker<Target>& worker : workers)
+    {
+        merge(result.read_latency, worker.result.read_latency);
+        merge(result.write_latency, worker.result.write_latency);
+        result.bytes += worker.result.bytes;
+        result.failures += worker.result.failures;
+        result.mismatches += worker.result.mismatches;
+    }
+
+    return result;
+}
+
+/**
+ * Compare the whole chip with the shadow, once the phase target has written everything back
+ */
+static uint32_t verify_chip(const AT24C256<>& eeprom)
+{
+    uint32_t mismatches = 0;
+
+    bool result = eeprom.read_stream(0x0000, MEMORY_SIZE, [](uint16_t address, const uint8_t* data, size_t size, void* user_data) {
+        for(size_t i = 0; i < size; ++i)
+        {
+            if(data[i] != g_shadow[address + i])
+                ++*static_cast<uint32_t*>(user_data);
+        }
+
+        return true;
+    }, &mismatches);
+
+    if(!result)
+    {
+        ESP_LOGE("stress", "Could not read the chip back");
+        return MEMORY_SIZE;
+    }
+
+    return mismatches;
+}
+
+/**
+ * Compare the throughput with the recorded baseline, record it if there is none
+ * Return false on a regression
+ */
+static bool check_baseline(const char* name, uint32_t bytes_per_s)
+{
+    nvs_handle_t handle;
+
+    if(nvs_open("AT24C256", NVS_READWRITE, &handle) != ESP_OK)
+    {
+        ESP_LOGE("stress", "Could not open NVS, no baseline check");
+        return true;
+    }
+
+    uint32_t baseline = 0;
+    esp_err_t err = nvs_get_u32(handle, name, &baseline);
+    bool passed = true;
+
+    if(err == ESP_OK && !AT24C256_STRESS_RECORD)
+    {
+        passed = (uint64_t) bytes_per_s * 100 >= (uint64_t) baseline * (100 - TOLERANCE_PERCENT);
+        printf("    baseline %" PRIu32 " B/s: %s\n", baseline, passed ? "ok" : "REGRESSION");
+    }
+    else
+    {
+        nvs_set_u32(handle, name, bytes_per_s);
+        nvs_commit(handle);
+        printf("    baseline recorded: %" PRIu32 " B/s\n", bytes_per_s);
+    }
+
+    nvs_close(handle);
+
+    return passed;
+}
+
+static bool report(const char* name, const PhaseResult& result, const AT24C256<>& eeprom)
+{
+    uint32_t chip_mismatches = verify_chip(eeprom);
+    uint32_t bytes_per_s = result.bytes * 1000000 / result.duration_us;
+
+    printf("  %-14s %10.2f %9" PRIu32 " %9" PRIu32 " %9" PRIu32 " %9" PRIu32 " %9" PRIu32 " %9" PRIu32 " %8" PRIu32 " %8" PRIu32 "\n", name,
+        bytes_per_s / 1024.0,
+        percentile_us(result.read_latency, 990), percentile_us(result.read_latency, 999), result.read_latency.max_us,
+        percentile_us(result.write_latency, 990), percentile_us(result.write_latency, 999), result.write_latency.max_us,
+        result.failures, result.mismatches + chip_mismatches);
+
+#if AT24C256_STATS
+    const AT24C256Stats& stats = eeprom.stats();
+    printf("    %" PRIu32 " page cycles, %" PRIu32 " NACKs, %" PRIu32 " retries, %" PRIu32 " busy polls\n", stats.page_cycles, stats.nacks, stats.retries, stats.busy_polls);
+#endif
+
+    // Never record the baseline of a broken run
+    if(result.failures != 0 || result.mismatches != 0 || chip_mismatches != 0)
+        return false;
+
+    return check_baseline(name, bytes_per_s);
+}
+
+/**
+ * Access paths under test: blocking write() and read(), and finish() to
+ * write back what is still queued or cached at the end of the phase
+ */
+struct SharedTarget
+{
+    AT24C256Shared<true>& shared;
+
+    bool write(uint16_t address, const uint8_t* buffer, size_t size) { return shared.write(address, buffer, size); }
+    bool read(uint16_t address, uint8_t* buffer, size_t size) { return shared.read(address, buffer, size); }
+    bool finish() { return true; }
+};
+
+struct AsyncTarget
+{
+    AT24C256Async<true>& async;
+
+    struct Completion
+    {
+        SemaphoreHandle_t done;
+        bool success;
+    };
+
+    static void complete(bool success, void* user_data)
+    {
+        Completion& completion = *static_cast<Completion*>(user_data);
+        completion.success = success;
+        xSemaphoreGive(completion.done);
+    }
+
+    template<typename Submit>
+    bool wait(Submit&& submit)
+    {
+        StaticSemaphore_t buffer;
+        Completion completion{ xSemaphoreCreateBinaryStatic(&buffer), false };
+
+        // Queue full: the other tasks are ahead
+        while(!submit(&completion))
+            vTaskDelay(1);
+
+        xSemaphoreTake(completion.done, portMAX_DELAY);
+        vSemaphoreDelete(completion.done);
+
+        return completion.success;
+    }
+
+    bool write(uint16_t address, const uint8_t* buffer, size_t size)
+    {
+        return wait([&](Completion* completion) { return async.write_async(address, std::span(buffer, size), complete, completion); });
+    }
+
+    bool read(uint16_t address, uint8_t* buffer, size_t size)
+    {
+        return wait([&](Completion* completion) { return async.read_async(address, std::span(buffer, size), complete, completion); });
+    }
+
+    bool finish() { return async.wait_idle(); }
+};
+
+struct PageCacheTarget
+{
+    AT24C256PageCache<true>& cache;
+
+    // The cache is not thread safe
+    SemaphoreHandle_t lock;
+
+    bool write(uint16_t address, const uint8_t* buffer, size_t size)
+    {
+        xSemaphoreTake(lock, portMAX_DELAY);
+        bool result = cache.write(address, buffer, size);
+        xSemaphoreGive(lock);
+
+        return result;
+    }
+
+    bool read(uint16_t address, uint8_t* buffer, size_t size)
+    {
+        xSemaphoreTake(lock, portMAX_DELAY);
+        bool result = cache.read(address, buffer, size);
+        xSemaphoreGive(lock);
+
+        return result;
+    }
+
+    bool finish() { return cache.flush(); }
+};
+
+struct WriteBehindTarget
+{
+    AT24C256WriteBehind<true>& queue;
+
+    bool write(uint16_t address, const uint8_t* buffer, size_t size)
+    {
+        // Queue full: wait for the drain task, for up to a second
+        for(size_t i = 0; i < 1000; ++i)
+        {
+            if(queue.write(address, buffer, size))
+                return true;
+
+            vTaskDelay(1);
+        }
+
+        return false;
+    }
+
+    bool read(uint16_t address, uint8_t* buffer, size_t size) { return queue.read(address, buffer, size); }
+    bool finish() { return queue.flush(); }
+};
+
+void app_main(void)
+{
+    esp_log_level_set("*", ESP_LOG_WARN);
+
+    esp_err_t err = nvs_flash_init();
+
+    if(err == ESP_ERR_NVS_NO_FREE_PAGES || err == ESP_ERR_NVS_NEW_VERSION_FOUND)
+    {
+        ESP_ERROR_CHECK(nvs_flash_erase());
+        err = nvs_flash_init();
+    }
+
+    ESP_ERROR_CHECK(err);
+
+    i2c_master_bus_config_t i2c_mst_config = {
+        .i2c_port = -1,
+        .sda_io_num = GPIO_NUM_21,
+        .scl_io_num = GPIO_NUM_22,
+        .clk_source = I2C_CLK_SRC_DEFAULT,
+        .glitch_ignore_cnt = 7,
+        .intr_priority = 0,
+        .trans_queue_depth = 0,
+        .flags = { .enable_internal_pullup = true}
+    };
+
+    i2c_master_bus_handle_t bus_handle;
+    ESP_ERROR_CHECK(i2c_new_master_bus(&i2c_mst_config, &bus_handle));
+
+    for(SemaphoreHandle_t& stripe : g_stripes)
+        stripe = xSemaphoreCreateMutex();
+
+    uint32_t seed = AT24C256_STRESS_SEED ? AT24C256_STRESS_SEED : esp_random();
+
+    printf("\nStress test: %zu tasks, %" PRId64 " s per phase, seed %" PRIu32 "\n", TASK_COUNT, DURATION_S, seed);
+
+    AT24C256Config ack_polling_config = { .scl_speed_hz = AT24C256<>::I2C_MASTER_FREQ_HZ_FAST };
+    AT24C256Config deferred_config = { .scl_speed_hz = AT24C256<>::I2C_MASTER_FREQ_HZ_FAST, .write_completion = AT24C256WriteCompletion::deferred };
+
+    {
+        AT24C256 eeprom(bus_handle, 0x51, ack_polling_config);
+
+        if(!eeprom.read_chunked(0x0000, g_shadow.data(), g_shadow.size()))
+        {
+            printf("Stress test FAILED: could not read the chip\n");
+            return;
+        }
+    }
+
+    printf("  %-14s %10s %9s %9s %9s %9s %9s %9s %8s %8s\n", "phase", "KB/s",
+        "r p99", "r p99.9", "r max", "w p99", "w p99.9", "w max", "failures", "errors");
+
+    bool passed = true;
+
+    {
+        AT24C256 eeprom(bus_handle, 0x51, ack_polling_config);
+        PhaseResult result;
+        {
+            AT24C256Shared shared(eeprom);
+            SharedTarget target{ shared };
+            result = run_phase(target, seed);
+        }
+        passed &= report("shared_ack", result, eeprom);
+    }
+
+    {
+        AT24C256 eeprom(bus_handle, 0x51, deferred_config);
+        PhaseResult result;
+        {
+            AT24C256Shared shared(eeprom);
+            SharedTarget target{ shared };
+            result = run_phase(target, seed + 1);
+        }
+        passed &= report("shared_def", result, eeprom);
+    }
+
+    {
+        AT24C256 eeprom(bus_handle, 0x51, deferred_config);
+        PhaseResult result;
+        {
+            AT24C256Async async(eeprom);
+            AsyncTarget target{ async };
+            result = run_phase(target, seed + 2);
+        }
+        passed &= report("async", result, eeprom);
+    }
+
+    {
+        AT24C256 eeprom(bus_handle, 0x51, ack_polling_config);
+        PhaseResult result;
+        {
+            AT24C256PageCache cache(eeprom, PAGE_CACHE_CAPACITY);
+            PageCacheTarget target{ cache, xSemaphoreCreateMutex() };
+            result = run_phase(target, seed + 3);
+            vSemaphoreDelete(target.lock);
+        }
+        passed &= report("page_cache", result, eeprom);
+    }
+
+    {
+        AT24C256 eeprom(bus_handle, 0x51, deferred_config);
+        PhaseResult result;
+        {
+            // About 5 KB: too large for the main task stack
+            auto queue = std::make_unique<AT24C256WriteBehind<true>>(eeprom);
+            WriteBehindTarget target{ *queue };
+            result = run_phase(target, seed + 4);
+        }
+        passed &= report("write_behind", result, eeprom);
+    }
+
+    for(SemaphoreHandle_t stripe : g_stripes)
+        vSemaphoreDelete(stripe);
+
+    ESP_ERROR_CHECK(i2c_del_master_bus(bus_handle));
+
+    printf("\nStress test %s\n", passed ? "passed" : "FAILED");
+}
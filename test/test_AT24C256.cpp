@@ -1,12 +1,26 @@
 #define UNITY_INCLUDE_DOUBLE
 #include <unity.h>
 #include <array>
+#include <cstring>
+#include <memory>
 #include <vector>
 
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "driver/i2c_master.h"
 
 #include "AT24C256.hpp"
+#include "AT24C256Array.hpp"
+#include "AT24C256Async.hpp"
+#include "AT24C256Atomic.hpp"
+#include "AT24C256Bus.hpp"
+#include "AT24C256KVStore.hpp"
+#include "AT24C256Log.hpp"
+#include "AT24C256Mirror.hpp"
+#include "AT24C256PageCache.hpp"
+#include "AT24C256ReadAhead.hpp"
+#include "AT24C256Shared.hpp"
+#include "AT24C256WriteBehind.hpp"
 
 extern "C" {
     void app_main(void);
@@ -184,8 +198,23 @@ void test_AT24C256_multi_read_write_edge()
     bool res_write = at24256.write(0x7FFE, data.data(), data.size()); // Past last address
     TEST_ASSERT_FALSE(res_write);
 
-    res_write = at24256.write(0x7FFA, data.data(), data.size()); // Right at the edge (last 5 bytes)
+    res_write = at24256.write(0x7FFA, data.data(), data.size()); // Ends one byte before the edge
     TEST_ASSERT_TRUE(res_write);
+
+    res_write = at24256.write(0x7FFB, data.data(), data.size()); // Right at the edge (last 5 bytes)
+    TEST_ASSERT_TRUE(res_write);
+
+    std::array<uint8_t, 5> result;
+    TEST_ASSERT_TRUE(at24256.read(0x7FFB, result.data(), result.size()));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(data.data(), result.data(), data.size());
+
+    TEST_ASSERT_FALSE(at24256.read(0x7FFE, result.data(), result.size())); // Past last address
+
+    // Unchecked: loops back to 0x0000
+    TEST_ASSERT_TRUE(at24256.read_unchecked(0x7FFE, result.data(), result.size()));
+    TEST_ASSERT_EQUAL(data[3], result[0]);
+    TEST_ASSERT_EQUAL(data[4], result[1]);
+    TEST_ASSERT_EQUAL(*at24256.read(0x0000), result[2]);
 }
 
 void test_AT24C256_read_write_arbitrary_type()
@@ -214,6 +243,29 @@ void test_AT24C256_read_write_arbitrary_type()
     S s2 = at24256.read<S>(0x10A).value();
     TEST_ASSERT_EQUAL_MEMORY(&s1, &s2, sizeof(S));
 
+    // Packed: no padding, across the page border at 0x140
+    using SLayout = AT24C256Layout<&S::a, &S::b, &S::c, &S::d, &S::s>;
+    static_assert(SLayout::SIZE < sizeof(S));
+
+    TEST_ASSERT_TRUE(at24256.write_packed<SLayout>(0x13C, s1));
+
+    std::array<uint8_t, SLayout::SIZE> packed;
+    TEST_ASSERT_TRUE(at24256.read(0x13C, packed.data(), packed.size()));
+    TEST_ASSERT_EQUAL_MEMORY(&s1.b, packed.data() + sizeof(int), sizeof(double));
+    TEST_ASSERT_EQUAL_MEMORY(&s1.s, packed.data() + SLayout::SIZE - sizeof(S::s), sizeof(S::s));
+
+    S s3 = at24256.read_packed<SLayout>(0x13C).value();
+    TEST_ASSERT_EQUAL(s1.a, s3.a);
+    TEST_ASSERT_EQUAL_DOUBLE(s1.b, s3.b);
+    TEST_ASSERT_EQUAL(s1.c, s3.c);
+    TEST_ASSERT_EQUAL(s1.d, s3.d);
+    TEST_ASSERT_EQUAL_STRING(s1.s, s3.s);
+
+    // Members left out are not read
+    S s4 = at24256.read_packed<AT24C256Layout<&S::a, &S::b>>(0x13C).value();
+    TEST_ASSERT_EQUAL(s1.a, s4.a);
+    TEST_ASSERT_EQUAL(0, s4.c);
+
     std::vector<float> vec1{59.6, 12.44, 126.9, 0.00023};
     TEST_ASSERT_TRUE(at24256.write(0x20A, vec1));
 
@@ -226,6 +278,1097 @@ void test_AT24C256_read_write_arbitrary_type()
 
 }
 
+void test_AT24C256_write_completion()
+{
+    std::array<uint8_t, 100> data;
+    for(size_t i=0; i<data.size(); ++i)
+    {
+        data[i] = 200 - i;
+    }
+
+    {
+        AT24C256 at24256(g_bus_handle, 0x51, { .write_completion = AT24C256WriteCompletion::fixed_delay });
+
+        TEST_ASSERT_TRUE(at24256.write(0x03E0, data.data(), data.size()));
+        TEST_ASSERT_EQUAL(200, at24256.read(0x03E0).value());
+    }
+
+    AT24C256 at24256(g_bus_handle, 0x51, { .write_completion = AT24C256WriteCompletion::ack_polling });
+
+    // Page 15 to page 17, 3 write cycles of at most 5 ms each
+    int64_t start = esp_timer_get_time();
+    TEST_ASSERT_TRUE(at24256.write(0x03E0, data.data(), data.size()));
+    int64_t elapsed = esp_timer_get_time() - start;
+
+    TEST_ASSERT_LESS_THAN(3 * 25000, elapsed);
+
+    auto result = at24256.read<std::array<uint8_t, 100>>(0x03E0).value();
+    TEST_ASSERT_EQUAL_MEMORY(data.data(), result.data(), data.size());
+}
+
+void test_AT24C256_deferred_write()
+{
+    AT24C256 at24256(g_bus_handle, 0x51, { .write_completion = AT24C256WriteCompletion::deferred });
+
+    TEST_ASSERT_TRUE(at24256.write(0x0452, 17));
+
+    // The read waits for the pending write cycle by itself
+    TEST_ASSERT_EQUAL(17, at24256.read(0x0452).value());
+
+    // No write pending, the read only costs the bus transfer
+    int64_t start = esp_timer_get_time();
+    TEST_ASSERT_EQUAL(17, at24256.read(0x0452).value());
+    TEST_ASSERT_LESS_THAN(5000, esp_timer_get_time() - start);
+
+    TEST_ASSERT_TRUE(at24256.write(0x0453, 18));
+    TEST_ASSERT_TRUE(at24256.wait_ready());
+    TEST_ASSERT_TRUE(at24256.wait_ready());
+    TEST_ASSERT_EQUAL(18, at24256.read(0x0453).value());
+}
+
+void test_AT24C256_skip_unchanged()
+{
+    AT24C256 at24256(g_bus_handle, 0x51, { .skip_unchanged = true });
+
+    std::array<uint8_t, 100> data;
+    for(size_t i=0; i<data.size(); ++i)
+        data[i] = i ^ 0x5A;
+
+    // Pages 68 to 70
+    uint16_t programmed = 0;
+    TEST_ASSERT_TRUE(at24256.write(0x1120, data.data(), data.size(), &programmed));
+
+    data[10] ^= 0xFF;
+    data[20] ^= 0xFF;
+    TEST_ASSERT_TRUE(at24256.write(0x1120, data.data(), data.size(), &programmed));
+    
+    // Both changes in page 68: 0x112A to 0x1134
+    TEST_ASSERT_EQUAL(11, programmed);
+
+    int64_t start = esp_timer_get_time();
+    TEST_ASSERT_TRUE(at24256.write(0x1120, data.data(), data.size(), &programmed));
+    int64_t duration = esp_timer_get_time() - start;
+
+    // Nothing to program, no write cycle
+    TEST_ASSERT_EQUAL(0, programmed);
+    TEST_ASSERT_LESS_THAN(5000, duration);
+
+    std::array<uint8_t, 100> result;
+    TEST_ASSERT_TRUE(at24256.read(0x1120, result.data(), result.size()));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(data.data(), result.data(), data.size());
+}
+
+void test_AT24C256_vectored()
+{
+    AT24C256 at24256(g_bus_handle, 0x51);
+
+    std::array<uint8_t, 8> header{ 1, 2, 3, 4, 5, 6, 7, 8 };
+    std::array<uint8_t, 70> body;
+    for(size_t i=0; i<body.size(); ++i)
+        body[i] = i;
+    uint32_t footer = 0xCAFEBABE;
+
+    // Pages 72 and 73, the body crossing the border
+    std::array<AT24C256<>::WriteSegment, 3> writes{{
+        { 0x1250, { (const uint8_t*) &footer, sizeof(footer) } },
+        { 0x1200, header },
+        { 0x120A, body },
+    }};
+
+    int64_t start = esp_timer_get_time();
+    TEST_ASSERT_TRUE(at24256.writev(writes));
+    int64_t duration = esp_timer_get_time() - start;
+
+    // A write cycle per page
+    TEST_ASSERT_LESS_THAN(2 * 5000 + 5000, duration);
+
+    std::array<uint8_t, 8> header_result;
+    std::array<uint8_t, 70> body_result;
+    uint32_t footer_result = 0;
+
+    std::array<AT24C256<>::ReadSegment, 3> reads{{
+        { 0x120A, body_result },
+        { 0x1250, { (uint8_t*) &footer_result, sizeof(footer_result) } },
+        { 0x1200, header_result },
+    }};
+
+    TEST_ASSERT_TRUE(at24256.readv(reads));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(header.data(), header_result.data(), header.size());
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(body.data(), body_result.data(), body.size());
+    TEST_ASSERT_EQUAL(footer, footer_result);
+
+    std::array<AT24C256<>::WriteSegment, 1> too_far{{ { 0x7FFC, header } }};
+    TEST_ASSERT_FALSE(at24256.writev(too_far));
+}
+
+void test_AT24C256_stats()
+{
+#if AT24C256_STATS
+    AT24C256 at24256(g_bus_handle, 0x51);
+
+    std::array<uint8_t, 100> data{};
+
+    // Pages 76 to 78
+    TEST_ASSERT_TRUE(at24256.write(0x1320, data.data(), data.size()));
+    TEST_ASSERT_TRUE(at24256.read(0x1320, data.data(), data.size()));
+    TEST_ASSERT_TRUE(at24256.read(0x1320).has_value());
+
+    const AT24C256Stats& stats = at24256.stats();
+
+    TEST_ASSERT_EQUAL(100, stats.bytes_written);
+    TEST_ASSERT_EQUAL(101, stats.bytes_read);
+    TEST_ASSERT_EQUAL(3, stats.page_cycles);
+    TEST_ASSERT_EQUAL(3, stats.write_latency.count);
+    TEST_ASSERT_EQUAL(2, stats.read_latency.count);
+    TEST_ASSERT_EQUAL(3, stats.wait_latency.count);
+    TEST_ASSERT_GREATER_THAN(0, stats.busy_wait_us);
+    TEST_ASSERT_EQUAL(0, stats.nacks);
+
+    // A write cycle lasts more than 100 us: never in the first bucket
+    TEST_ASSERT_EQUAL(0, stats.wait_latency.buckets[0]);
+
+    at24256.reset_stats();
+    TEST_ASSERT_EQUAL(0, at24256.stats().bytes_read);
+#else
+    TEST_IGNORE_MESSAGE("Built without AT24C256_STATS");
+#endif
+}
+
+void test_AT24C256_retry()
+{
+    // Two objects on the same chip: the second one does not know about the write cycle
+    // started by the first one, and is not acknowledged while it runs
+    AT24C256 deferred(g_bus_handle, 0x51, { .write_completion = AT24C256WriteCompletion::deferred });
+
+    std::array<uint8_t, 16> data;
+    data.fill(0x42);
+
+    {
+        AT24C256 no_retry(g_bus_handle, 0x51, { .max_attempts = 1 });
+
+        // Page 80
+        TEST_ASSERT_TRUE(deferred.write_page(0x1400, data.data(), data.size()));
+        TEST_ASSERT_FALSE(no_retry.write_page(0x1410, data.data(), data.size()));
+        TEST_ASSERT_TRUE(deferred.wait_ready());
+    }
+
+    AT24C256 retry(g_bus_handle, 0x51, { .max_attempts = 10, .retry_backoff_us = 500, .retry_backoff_max_us = 2000 });
+
+    TEST_ASSERT_TRUE(deferred.write_page(0x1400, data.data(), data.size()));
+    TEST_ASSERT_TRUE(retry.write_page(0x1410, data.data(), data.size()));
+
+#if AT24C256_STATS
+    TEST_ASSERT_GREATER_THAN(0, retry.stats().retries);
+#endif
+
+    std::array<uint8_t, 32> result;
+    TEST_ASSERT_TRUE(retry.read(0x1400, result.data(), result.size()));
+
+    for(uint8_t byte : result)
+        TEST_ASSERT_EQUAL(0x42, byte);
+}
+
+void test_AT24C256_checked()
+{
+    AT24C256 at24256(g_bus_handle, 0x51, { .verify_writes = true });
+
+    struct Record
+    {
+        uint32_t counter;
+        uint8_t data[120];
+    };
+
+    Record record{ .counter = 7, .data = {} };
+    for(size_t i=0; i<sizeof(record.data); ++i)
+        record.data[i] = i;
+
+    // Pages 84 to 86, CRC32 included
+    TEST_ASSERT_TRUE(at24256.write_checked(0x1510, record));
+
+    Record result{};
+    TEST_ASSERT_TRUE(at24256.read_checked(0x1510, result));
+    TEST_ASSERT_EQUAL(0, std::memcmp(&record, &result, sizeof(record)));
+
+    uint32_t crc = 0;
+    TEST_ASSERT_TRUE(at24256.crc32(0x1510, sizeof(record), crc));
+    TEST_ASSERT_EQUAL(*at24256.read<uint32_t>(0x1510 + sizeof(record)), crc);
+
+    // Corrupted behind its back
+    TEST_ASSERT_TRUE(at24256.write(0x1520, (uint8_t) 0xFF));
+    TEST_ASSERT_FALSE(at24256.read_checked(0x1510, result));
+
+    std::array<uint8_t, 150> data;
+    for(size_t i=0; i<data.size(); ++i)
+        data[i] = i * 3;
+
+    TEST_ASSERT_TRUE(at24256.write(0x15A0, data.data(), data.size()));
+}
+
+void test_AT24C256_geometry()
+{
+    static_assert(AT24C512<>::MEMORY_SIZE == 0x10000 && AT24C512<>::PAGE_SHIFT == 7);
+    static_assert(AT24C64<>::MEMORY_SIZE == 0x2000 && AT24C64<>::PAGE_MASK == 0x1F);
+
+    // 32 bytes pages fit in the 64 bytes pages of the AT24C256
+    AT24C64 at2464(g_bus_handle, 0x51);
+    AT24C256 at24256(g_bus_handle, 0x51);
+
+    std::array<uint8_t, 100> data;
+    for(size_t i=0; i<data.size(); ++i)
+        data[i] = 0x5A ^ i;
+
+    // 4 pages of 32 bytes from 0x1E10
+    TEST_ASSERT_TRUE(at2464.write(0x1E10, data.data(), data.size()));
+
+#if AT24C256_STATS
+    TEST_ASSERT_EQUAL(4, at2464.stats().page_cycles);
+#endif
+
+    std::array<uint8_t, 100> result;
+    TEST_ASSERT_TRUE(at24256.read(0x1E10, result.data(), result.size()));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(data.data(), result.data(), data.size());
+
+    TEST_ASSERT_FALSE(at2464.write_page(0x1E30, data.data(), 40));
+    TEST_ASSERT_FALSE(at2464.read(0x2000).has_value());
+
+    // Up to the end of a 64 KB chip, whose last chunk ends at 0x10000
+    // The AT24C256 ignores the top address bit: it is read twice
+    AT24C512 at24512(g_bus_handle, 0x51);
+    uint32_t crc = 0;
+    TEST_ASSERT_TRUE(at24512.crc32(0x0000, 0xFFFF, crc));
+}
+
+void test_AT24C256_scl_speed()
+{
+    AT24C256 at24256(g_bus_handle, 0x51, { .scl_speed_hz = AT24C256<>::I2C_MASTER_FREQ_HZ_FAST });
+
+    std::array<uint8_t, 64> data;
+    for(size_t i=0; i<data.size(); ++i)
+    {
+        data[i] = i * 3;
+    }
+
+    TEST_ASSERT_TRUE(at24256.write_page(0x0C00, data.data(), data.size()));
+
+    auto result = at24256.read<std::array<uint8_t, 64>>(0x0C00).value();
+    TEST_ASSERT_EQUAL_MEMORY(data.data(), result.data(), data.size());
+}
+
+void test_AT24C256_current_address()
+{
+    AT24C256 at24256(g_bus_handle, 0x51, { .track_address = true });
+
+    std::array<uint8_t, 48> data;
+    for(size_t i=0; i<data.size(); ++i)
+    {
+        data[i] = i + 11;
+    }
+
+    TEST_ASSERT_TRUE(at24256.write(0x1D40, data.data(), data.size()));
+    TEST_ASSERT_FALSE(at24256.current_address().has_value());
+
+    // Addressed read, then sequential reads without the word address
+    std::array<uint8_t, 16> result;
+    for(size_t i=0; i<3; ++i)
+    {
+        TEST_ASSERT_TRUE(at24256.read(0x1D40 + i*16, result.data(), result.size()));
+        TEST_ASSERT_EQUAL_MEMORY(data.data() + i*16, result.data(), result.size());
+        TEST_ASSERT_EQUAL_HEX16(0x1D50 + i*16, at24256.current_address().value());
+    }
+
+    TEST_ASSERT_TRUE(at24256.read(0x1D40, result.data(), 8));
+    TEST_ASSERT_EQUAL(data[0], result[0]);
+
+    TEST_ASSERT_TRUE(at24256.read_current(result.data(), 8));
+    TEST_ASSERT_EQUAL_MEMORY(data.data() + 8, result.data(), 8);
+    TEST_ASSERT_EQUAL(data[16], at24256.read(0x1D50).value());
+
+    // A write moves the counter of the chip
+    TEST_ASSERT_TRUE(at24256.write(0x1D70, (uint8_t) 0));
+    TEST_ASSERT_FALSE(at24256.current_address().has_value());
+}
+
+void test_AT24C256_page_cache()
+{
+    AT24C256 at24256(g_bus_handle, 0x51);
+
+    std::array<uint8_t, 64> zeros{};
+    TEST_ASSERT_TRUE(at24256.write_page(0x0D00, zeros.data(), zeros.size()));
+
+    {
+        AT24C256PageCache cache(at24256, 2);
+
+        TEST_ASSERT_TRUE(cache.write(0x0D04, (uint32_t) 1234));
+        TEST_ASSERT_TRUE(cache.write(0x0D10, 5.0f));
+
+        TEST_ASSERT_EQUAL(1234, cache.read<uint32_t>(0x0D04).value());
+        TEST_ASSERT_EQUAL_FLOAT(5.0f, cache.read<float>(0x0D10).value());
+
+        // Not on the chip yet
+        TEST_ASSERT_EQUAL(0, at24256.read<uint32_t>(0x0D04).value());
+
+        TEST_ASSERT_TRUE(cache.flush());
+        TEST_ASSERT_EQUAL(1234, at24256.read<uint32_t>(0x0D04).value());
+        TEST_ASSERT_EQUAL_FLOAT(5.0f, at24256.read<float>(0x0D10).value());
+
+        // 3 pages in a 2 pages cache: the least recently used one is written back
+        TEST_ASSERT_TRUE(cache.write(0x0D40, (uint8_t) 1));
+        TEST_ASSERT_TRUE(cache.write(0x0D80, (uint8_t) 2));
+        TEST_ASSERT_TRUE(cache.write(0x0DC0, (uint8_t) 3));
+
+        TEST_ASSERT_EQUAL(1, at24256.read(0x0D40).value());
+
+        // Mix of resident and non-resident pages
+        std::array<uint8_t, 0x100> all;
+        TEST_ASSERT_TRUE(cache.read(0x0D00, all.data(), all.size()));
+        TEST_ASSERT_EQUAL(1, all[0x40]);
+        TEST_ASSERT_EQUAL(2, all[0x80]);
+        TEST_ASSERT_EQUAL(3, all[0xC0]);
+
+        TEST_ASSERT_FALSE(cache.write(0x7FFF, (uint16_t) 0));
+    }
+
+    // Dirty pages are flushed on destruction
+    TEST_ASSERT_EQUAL(2, at24256.read(0x0D80).value());
+    TEST_ASSERT_EQUAL(3, at24256.read(0x0DC0).value());
+}
+
+void test_AT24C256_async()
+{
+    AT24C256 at24256(g_bus_handle, 0x51, { .write_completion = AT24C256WriteCompletion::deferred });
+
+    std::array<uint8_t, 150> data;
+    for(size_t i=0; i<data.size(); ++i)
+    {
+        data[i] = i + 7;
+    }
+
+    std::array<uint8_t, 150> result{};
+    int done = 0;
+
+    auto count = [](bool success, void* user_data) {
+        if(success)
+            ++(*static_cast<int*>(user_data));
+    };
+
+    {
+        AT24C256Async async(at24256);
+
+        TEST_ASSERT_TRUE(async.write_async(0x0E10, data, count, &done));
+        TEST_ASSERT_TRUE(async.read_async(0x0E10, result, count, &done));
+
+        TEST_ASSERT_TRUE(async.wait_idle());
+        TEST_ASSERT_EQUAL(2, done);
+        TEST_ASSERT_EQUAL_MEMORY(data.data(), result.data(), data.size());
+
+        // Larger than the chip: refused rather than truncated
+        std::vector<uint8_t> big(AT24C256<>::MEMORY_SIZE + 1);
+        TEST_ASSERT_FALSE(async.write_async(0x0000, big));
+        TEST_ASSERT_FALSE(async.read_async(0x0000, big));
+
+        TEST_ASSERT_TRUE(async.write_async(0x0E10, std::span(data).first(10)));
+    }
+
+    // Queued operations are done before destruction
+    TEST_ASSERT_EQUAL(data[9], at24256.read(0x0E19).value());
+}
+
+struct SharedWriterContext
+{
+    AT24C256Shared<true>* shared;
+    uint16_t address;
+    uint8_t value;
+    SemaphoreHandle_t done;
+    bool result;
+};
+
+void shared_writer_task(void* arg)
+{
+    SharedWriterContext* context = static_cast<SharedWriterContext*>(arg);
+
+    std::array<uint8_t, 16> data;
+    data.fill(context->value);
+
+    context->result = context->shared->write(context->address, data.data(), data.size());
+
+    xSemaphoreGive(context->done);
+    vTaskDelete(nullptr);
+}
+
+void test_AT24C256_shared()
+{
+    AT24C256 at24256(g_bus_handle, 0x51);
+    AT24C256Shared shared(at24256);
+
+    SemaphoreHandle_t done = xSemaphoreCreateCounting(4, 0);
+    std::array<SharedWriterContext, 4> contexts;
+
+    // 4 tasks writing 16 bytes each into page 60
+    for(size_t i=0; i<contexts.size(); ++i)
+    {
+        contexts[i] = { &shared, (uint16_t)(0x0F00 + i*16), (uint8_t)(i+1), done, false };
+        xTaskCreate(shared_writer_task, "shared_writer", 4096, &contexts[i], 5, nullptr);
+    }
+
+    for(size_t i=0; i<contexts.size(); ++i)
+    {
+        xSemaphoreTake(done, portMAX_DELAY);
+    }
+
+    for(size_t i=0; i<contexts.size(); ++i)
+    {
+        TEST_ASSERT_TRUE(contexts[i].result);
+
+        std::array<uint8_t, 16> result;
+        TEST_ASSERT_TRUE(shared.read(contexts[i].address, result.data(), result.size()));
+
+        for(uint8_t byte : result)
+        {
+            TEST_ASSERT_EQUAL(i+1, byte);
+        }
+    }
+
+    bool result = shared.with_lock([](const AT24C256<true>& eeprom) {
+        return eeprom.write(0x0F40, 99) && eeprom.read(0x0F40).value() == 99;
+    });
+
+    TEST_ASSERT_TRUE(result);
+
+    // Queued behind the lock: the most recent write starts lower, overlaps and wins
+    SharedWriterContext older = { &shared, 0x0F28, 5, done, false };
+    SharedWriterContext newer = { &shared, 0x0F20, 6, done, false };
+
+    shared.with_lock([&](const AT24C256<true>&) {
+        xTaskCreate(shared_writer_task, "shared_writer", 4096, &older, 5, nullptr);
+        vTaskDelay(pdMS_TO_TICKS(10));
+        xTaskCreate(shared_writer_task, "shared_writer", 4096, &newer, 5, nullptr);
+        vTaskDelay(pdMS_TO_TICKS(10));
+    });
+
+    xSemaphoreTake(done, portMAX_DELAY);
+    xSemaphoreTake(done, portMAX_DELAY);
+    vSemaphoreDelete(done);
+
+    TEST_ASSERT_TRUE(older.result && newer.result);
+
+    std::array<uint8_t, 24> overlapped;
+    TEST_ASSERT_TRUE(shared.read(0x0F20, overlapped.data(), overlapped.size()));
+
+    for(size_t i=0; i<overlapped.size(); ++i)
+    {
+        TEST_ASSERT_EQUAL(i < 16 ? 6 : 5, overlapped[i]);
+    }
+}
+
+void test_AT24C256_array()
+{
+    std::array<uint8_t, 1> addresses{ 0x51 };
+    AT24C256Array array(g_bus_handle, addresses, true);
+
+    TEST_ASSERT_EQUAL(AT24C256<>::MEMORY_SIZE, array.size());
+
+    std::array<uint8_t, 130> data;
+    for(size_t i=0; i<data.size(); ++i)
+    {
+        data[i] = 255 - i;
+    }
+
+    // Up to the very last byte
+    TEST_ASSERT_TRUE(array.write(array.size() - data.size(), data.data(), data.size()));
+    TEST_ASSERT_FALSE(array.write(array.size() - data.size() + 1, data.data(), data.size()));
+
+    std::array<uint8_t, 130> result;
+    TEST_ASSERT_TRUE(array.read(array.size() - result.size(), result.data(), result.size()));
+    TEST_ASSERT_EQUAL_MEMORY(data.data(), result.data(), data.size());
+
+    TEST_ASSERT_TRUE(array.write(0x1010, 3.5f));
+    TEST_ASSERT_EQUAL_FLOAT(3.5f, array.read<float>(0x1010).value());
+
+    // Unsafe mode: past the last chip wraps around to the first one
+    AT24C256Array<false> linear(g_bus_handle, addresses);
+    TEST_ASSERT_TRUE(linear.write(linear.size() + 0x1010, 7.25f));
+    TEST_ASSERT_EQUAL_FLOAT(7.25f, linear.read<float>(0x1010));
+}
+
+bool sum_chunk(uint16_t, const uint8_t* data, size_t size, void* user_data)
+{
+    for(size_t i=0; i<size; ++i)
+    {
+        *static_cast<uint32_t*>(user_data) += data[i];
+    }
+
+    return true;
+}
+
+void test_AT24C256_read_ahead()
+{
+    AT24C256 at24256(g_bus_handle, 0x51);
+
+    // Pages 112 and 113
+    std::array<uint32_t, 32> words;
+    for(size_t i=0; i<words.size(); ++i)
+        words[i] = 0x10000 * i + 7;
+
+    TEST_ASSERT_TRUE(at24256.write(0x1C00, words));
+
+    AT24C256ReadAhead reader(at24256, 64);
+
+#if AT24C256_STATS
+    at24256.reset_stats();
+#endif
+
+    // The first read goes to the chip, the second one fetches 64 bytes
+    for(size_t i=0; i<17; ++i)
+        TEST_ASSERT_EQUAL(words[i], reader.read<uint32_t>(0x1C00 + 4 * i).value());
+
+#if AT24C256_STATS
+    TEST_ASSERT_EQUAL(2, at24256.stats().read_latency.count);
+#endif
+
+    // Written through
+    TEST_ASSERT_TRUE(reader.write(0x1C08, (const uint8_t*) &words[0], sizeof(uint32_t)));
+    TEST_ASSERT_EQUAL(words[0], reader.read<uint32_t>(0x1C08).value());
+    TEST_ASSERT_EQUAL(words[0], at24256.read<uint32_t>(0x1C08).value());
+
+    TEST_ASSERT_FALSE(reader.read<uint32_t>(0x7FFE).has_value());
+
+    // Unsafe mode: a sequential read looping back to 0x0000 is read as a whole
+    AT24C256<false> unsafe(g_bus_handle, 0x51);
+    AT24C256ReadAhead unsafe_reader(unsafe, 64);
+
+    std::array<uint8_t, 32> expected;
+    unsafe.read(0x7FF0, expected.data(), expected.size());
+
+    std::array<uint8_t, 32> looped;
+    TEST_ASSERT_TRUE(unsafe_reader.read(0x7FE0, looped.data(), 16));
+    TEST_ASSERT_TRUE(unsafe_reader.read(0x7FF0, looped.data(), looped.size()));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected.data(), looped.data(), looped.size());
+}
+
+void test_AT24C256_read_stream()
+{
+    AT24C256 at24256(g_bus_handle, 0x51);
+
+    std::array<uint8_t, 64> data;
+    data.fill(2);
+
+    for(uint16_t address=0x7E00; address<0x8000; address+=data.size())
+    {
+        TEST_ASSERT_TRUE(at24256.write_page(address, data.data(), data.size()));
+    }
+
+    std::array<uint8_t, 0x200> result;
+    TEST_ASSERT_TRUE(at24256.read_chunked(0x7E00, result.data(), result.size(), 100));
+
+    for(uint8_t byte : result)
+    {
+        TEST_ASSERT_EQUAL(2, byte);
+    }
+
+    // No loop back to 0x0000
+    TEST_ASSERT_FALSE(at24256.read_chunked(0x7E01, result.data(), result.size()));
+
+    uint32_t sum = 0;
+    TEST_ASSERT_TRUE(at24256.read_stream(0x7E00, 0x200, sum_chunk, &sum, 48));
+    TEST_ASSERT_EQUAL(2 * 0x200, sum);
+
+    AT24C256Async async(at24256);
+
+    sum = 0;
+    TEST_ASSERT_TRUE(async.read_stream(0x7E00, 0x200, sum_chunk, &sum, 48));
+    TEST_ASSERT_EQUAL(2 * 0x200, sum);
+}
+
+bool collect_record(const uint8_t* data, size_t size, void* user_data)
+{
+    std::vector<uint32_t>& records = *static_cast<std::vector<uint32_t>*>(user_data);
+
+    TEST_ASSERT_EQUAL(sizeof(uint32_t), size);
+
+    uint32_t record;
+    std::memcpy(&record, data, size);
+    records.push_back(record);
+
+    return true;
+}
+
+void test_AT24C256_log()
+{
+    AT24C256 at24256(g_bus_handle, 0x51);
+
+    std::vector<uint32_t> records;
+    uint32_t last = 0;
+
+    // Pages 400 to 407
+    {
+        AT24C256Log log(at24256, 400, 8);
+        TEST_ASSERT_TRUE(log.mount());
+        TEST_ASSERT_TRUE(log.for_each(collect_record, &records));
+
+        if(!records.empty())
+            last = records.back();
+
+        // 11 records of 5 bytes per page: 100 records fill the 8 pages and wrap
+        for(uint32_t i=1; i<=100; ++i)
+        {
+            TEST_ASSERT_TRUE(log.append(last + i));
+        }
+
+        std::array<uint8_t, AT24C256Log<>::MAX_RECORD_SIZE + 1> too_big;
+        TEST_ASSERT_FALSE(log.append(too_big.data(), too_big.size()));
+    }
+
+    records.clear();
+
+    AT24C256Log log(at24256, 400, 8);
+    TEST_ASSERT_TRUE(log.mount());
+    TEST_ASSERT_TRUE(log.for_each(collect_record, &records));
+
+    // The oldest pages were overwritten, the newest records are in order
+    TEST_ASSERT_GREATER_THAN(60, records.size());
+    TEST_ASSERT_EQUAL(last + 100, records.back());
+
+    for(size_t i=1; i<records.size(); ++i)
+    {
+        TEST_ASSERT_EQUAL(records[i-1] + 1, records[i]);
+    }
+
+    // Page 0 of the range corrupted (torn rewrite): mounted from the other pages
+    if(at24256.read<uint32_t>(400 * AT24C256<>::PAGE_SIZE).value() == log.sequence() - 1)
+    {
+        // Newest page: its records would be lost
+        TEST_ASSERT_TRUE(log.append(last + 101));
+        TEST_ASSERT_TRUE(log.flush());
+        ++last;
+    }
+
+    uint32_t sequence = log.sequence();
+    uint8_t crc = at24256.read(400 * AT24C256<>::PAGE_SIZE + 6).value();
+    TEST_ASSERT_TRUE(at24256.write(400 * AT24C256<>::PAGE_SIZE + 6, (uint8_t) ~crc));
+
+    AT24C256Log remounted(at24256, 400, 8);
+    TEST_ASSERT_TRUE(remounted.mount());
+    TEST_ASSERT_EQUAL(sequence, remounted.sequence());
+
+    records.clear();
+    TEST_ASSERT_TRUE(remounted.for_each(collect_record, &records));
+    TEST_ASSERT_EQUAL(last + 100, records.back());
+}
+
+void test_AT24C256_kv_store()
+{
+    AT24C256 at24256(g_bus_handle, 0x51);
+
+    // Pages 420 to 427
+    {
+        AT24C256KVStore store(at24256, 420, 8);
+        TEST_ASSERT_TRUE(store.format());
+
+        TEST_ASSERT_FALSE(store.contains(1));
+        TEST_ASSERT_FALSE(store.get<uint32_t>(1).has_value());
+
+        // Enough updates to wrap around the range several times
+        for(uint32_t i=0; i<200; ++i)
+        {
+            TEST_ASSERT_TRUE(store.put(i % 10, i));
+        }
+
+        TEST_ASSERT_TRUE(store.put<uint16_t>(20, 0xBEEF));
+        TEST_ASSERT_TRUE(store.remove(5));
+        TEST_ASSERT_FALSE(store.get<uint16_t>(1).has_value());
+
+        std::array<uint8_t, AT24C256KVStore<>::MAX_VALUE_SIZE + 1> too_big;
+        TEST_ASSERT_FALSE(store.put(30, too_big.data(), too_big.size()));
+    }
+
+    AT24C256KVStore store(at24256, 420, 8);
+    TEST_ASSERT_TRUE(store.mount());
+
+    for(uint32_t key=0; key<10; ++key)
+    {
+        if(key == 5)
+        {
+            TEST_ASSERT_FALSE(store.contains(key));
+            continue;
+        }
+
+        auto value = store.get<uint32_t>(key);
+        TEST_ASSERT_TRUE(value.has_value());
+        TEST_ASSERT_EQUAL(190 + key, *value);
+    }
+
+    TEST_ASSERT_EQUAL(2, store.value_size(20));
+    TEST_ASSERT_EQUAL(0xBEEF, *store.get<uint16_t>(20));
+
+    // More live data than the range can hold
+    std::array<uint8_t, AT24C256KVStore<>::MAX_VALUE_SIZE> big;
+    big.fill(0x5A);
+
+    bool full = false;
+
+    for(uint8_t key=100; key<110 && !full; ++key)
+    {
+        full = !store.put(key, big.data(), big.size());
+    }
+
+    TEST_ASSERT_TRUE(full);
+    TEST_ASSERT_EQUAL(0xBEEF, *store.get<uint16_t>(20));
+}
+
+void test_AT24C256_kv_store_mount()
+{
+    AT24C256 at24256(g_bus_handle, 0x51);
+
+    // Pages 300 to 363: a few pages written, the rest unused
+    {
+        AT24C256KVStore store(at24256, 300, 64);
+        TEST_ASSERT_TRUE(store.format());
+
+        for(uint32_t key=0; key<30; ++key)
+        {
+            TEST_ASSERT_TRUE(store.put(key, key * 3));
+        }
+
+        TEST_ASSERT_TRUE(store.flush());
+    }
+
+#if AT24C256_STATS
+    at24256.reset_stats();
+#endif
+
+    AT24C256KVStore store(at24256, 300, 64);
+    TEST_ASSERT_TRUE(store.mount());
+
+#if AT24C256_STATS
+    // Binary search and replay of the live pages, not a read of every page
+    TEST_ASSERT_LESS_THAN(32, at24256.stats().read_latency.count);
+#endif
+
+    for(uint32_t key=0; key<30; ++key)
+    {
+        TEST_ASSERT_EQUAL(key * 3, *store.get<uint32_t>(key));
+    }
+}
+
+struct AtomicRecord
+{
+    uint32_t counter;
+    uint8_t data[120];
+    uint32_t counter_copy;
+};
+
+void test_AT24C256_atomic()
+{
+    AT24C256 at24256(g_bus_handle, 0x51);
+
+    uint32_t counter = 0;
+    uint32_t initial = 0;
+
+    // Pages 440 to 448: 4 logical pages
+    {
+        AT24C256Atomic region(at24256, 440, 4);
+        TEST_ASSERT_TRUE(region.mount());
+
+        // The record spans 3 pages
+        auto record = region.read<AtomicRecord>(10);
+        TEST_ASSERT_TRUE(record.has_value());
+
+        initial = record->counter;
+
+        if(record->counter == record->counter_copy)
+            counter = record->counter;
+
+        AtomicRecord next{ .counter = counter + 1, .data = {}, .counter_copy = counter + 1 };
+        TEST_ASSERT_TRUE(region.write(10, next));
+        TEST_ASSERT_TRUE(region.pending());
+        TEST_ASSERT_EQUAL(counter + 1, region.read<AtomicRecord>(10)->counter);
+
+        // Never committed
+        region.rollback();
+        TEST_ASSERT_EQUAL(record->counter, region.read<AtomicRecord>(10)->counter);
+
+        TEST_ASSERT_TRUE(region.write(10, next));
+    }
+
+    // The write staged above was never committed
+    {
+        AT24C256Atomic region(at24256, 440, 4);
+        TEST_ASSERT_TRUE(region.mount());
+
+        TEST_ASSERT_EQUAL(initial, region.read<AtomicRecord>(10)->counter);
+
+        AtomicRecord next{ .counter = counter + 1, .data = {}, .counter_copy = counter + 1 };
+        TEST_ASSERT_TRUE(region.write(10, next));
+        TEST_ASSERT_TRUE(region.commit());
+        TEST_ASSERT_FALSE(region.pending());
+    }
+
+    AT24C256Atomic region(at24256, 440, 4);
+    TEST_ASSERT_TRUE(region.mount());
+
+    AtomicRecord record = *region.read<AtomicRecord>(10);
+    TEST_ASSERT_EQUAL(counter + 1, record.counter);
+    TEST_ASSERT_EQUAL(counter + 1, record.counter_copy);
+
+    uint8_t byte = 0;
+    TEST_ASSERT_FALSE(region.write(region.size(), &byte, 1));
+}
+
+void test_AT24C256_mirror()
+{
+    AT24C256 at24256(g_bus_handle, 0x51, { .scl_speed_hz = AT24C256<>::I2C_MASTER_FREQ_HZ_FAST });
+
+    std::array<uint8_t, 150> data;
+    for(size_t i=0; i<data.size(); ++i)
+        data[i] = 0xA0 ^ i;
+
+    // Pages 96 to 98
+    TEST_ASSERT_TRUE(at24256.write(0x1800, data.data(), data.size()));
+    TEST_ASSERT_TRUE(at24256.wait_ready());
+
+    {
+        AT24C256Mirror mirror(at24256, 50);
+
+        TEST_ASSERT_FALSE(mirror.loaded(96));
+
+        std::span<const uint8_t> view = mirror.view(0x1800, data.size());
+        TEST_ASSERT_EQUAL(data.size(), view.size());
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(data.data(), view.data(), data.size());
+        TEST_ASSERT_TRUE(mirror.loaded(98));
+        TEST_ASSERT_FALSE(mirror.loaded(99));
+
+        // Written back by the sync task, the view sees the new bytes
+        uint32_t value = 0x12345678;
+        TEST_ASSERT_TRUE(mirror.write(0x183E, value));
+        TEST_ASSERT_TRUE(mirror.pending());
+        TEST_ASSERT_EQUAL(0x78, view[0x3E]);
+
+        vTaskDelay(pdMS_TO_TICKS(200));
+        TEST_ASSERT_FALSE(mirror.pending());
+
+        // Partial page 99 is loaded first, so the end of the page is kept
+        TEST_ASSERT_TRUE(mirror.write(0x18C0, data.data(), 10));
+        TEST_ASSERT_EQUAL(data.size() - 10, mirror.view(0x18C0 + 10, data.size() - 10).size());
+
+        TEST_ASSERT_TRUE(mirror.read<uint32_t>(0x7FFC).has_value());
+        TEST_ASSERT_FALSE(mirror.read<uint32_t>(0x7FFE).has_value());
+    }
+
+    // Written back on destruction
+    std::array<uint8_t, 10> result;
+    TEST_ASSERT_TRUE(at24256.read(0x18C0, result.data(), result.size()));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(data.data(), result.data(), result.size());
+
+    uint32_t value = 0;
+    TEST_ASSERT_TRUE(at24256.read(0x183E, (uint8_t*) &value, sizeof(value)));
+    TEST_ASSERT_EQUAL_HEX32(0x12345678, value);
+}
+
+void test_AT24C256_write_behind()
+{
+    AT24C256 at24256(g_bus_handle, 0x51, { .scl_speed_hz = AT24C256<>::I2C_MASTER_FREQ_HZ_FAST });
+
+    std::array<uint8_t, 100> data;
+    for(size_t i=0; i<data.size(); ++i)
+        data[i] = 0xC3 ^ i;
+
+    std::array<uint8_t, 4> patch{ 1, 2, 3, 4 };
+
+    {
+        // About 5 KB: too large for the main task stack
+        auto queue = std::make_unique<AT24C256WriteBehind<>>(at24256);
+
+        // Pages 104 to 106: only copied
+        int64_t start = esp_timer_get_time();
+        TEST_ASSERT_TRUE(queue->write(0x1A10, data.data(), data.size()));
+        TEST_ASSERT_LESS_THAN(1000, esp_timer_get_time() - start);
+
+        // Merged into the slot of page 104 if still queued
+        TEST_ASSERT_TRUE(queue->write(0x1A20, patch.data(), patch.size()));
+        std::copy(patch.begin(), patch.end(), data.begin() + 0x10);
+
+        std::array<uint8_t, 100> result;
+        TEST_ASSERT_TRUE(queue->read(0x1A10, result.data(), result.size()));
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(data.data(), result.data(), data.size());
+
+        TEST_ASSERT_TRUE(queue->flush(pdMS_TO_TICKS(1000)));
+        TEST_ASSERT_EQUAL(0, queue->pending());
+
+        // More pages than slots: nothing queued
+        std::vector<uint8_t> big((AT24C256WriteBehind<>::SLOT_COUNT + 1) * AT24C256<>::PAGE_SIZE);
+        TEST_ASSERT_FALSE(queue->write(0x1A00, big.data(), big.size()));
+        TEST_ASSERT_EQUAL(0, queue->pending());
+
+        // Drained by the destructor
+        TEST_ASSERT_TRUE(queue->write(0x1A70, patch.data(), patch.size()));
+    }
+
+    std::array<uint8_t, 100> result;
+    TEST_ASSERT_TRUE(at24256.read(0x1A10, result.data(), result.size()));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(data.data(), result.data(), data.size() - 4);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(patch.data(), result.data() + 0x60, patch.size());
+}
+
+void test_AT24C256_write_batch()
+{
+    AT24C256 at24256(g_bus_handle, 0x51, { .write_completion = AT24C256WriteCompletion::deferred });
+
+    std::array<uint8_t, 8> record;
+
+    {
+        auto queue = std::make_unique<AT24C256WriteBehind<>>(at24256, AT24C256WriteBehindConfig{ .batch_deadline_ms = 500, .batch_pages = 3, .write_cycle_sleep_us = 4000 });
+
+        // Nothing to flush: batching is not cut short
+        TEST_ASSERT_TRUE(queue->flush(0));
+
+        // Held back until the third page is queued
+        for(size_t i=0; i<3; ++i)
+        {
+            record.fill(i + 1);
+            TEST_ASSERT_TRUE(queue->write(0x1F00 + i * AT24C256<>::PAGE_SIZE, record.data(), record.size()));
+
+            if(i < 2)
+            {
+                vTaskDelay(pdMS_TO_TICKS(50));
+                TEST_ASSERT_EQUAL(i + 1, queue->pending());
+            }
+        }
+
+        TEST_ASSERT_TRUE(queue->flush(pdMS_TO_TICKS(100)));
+
+        // flush() does not wait for the deadline
+        int64_t start = esp_timer_get_time();
+        record.fill(9);
+        TEST_ASSERT_TRUE(queue->write(0x1FC0, record.data(), record.size()));
+        TEST_ASSERT_TRUE(queue->flush(pdMS_TO_TICKS(100)));
+        TEST_ASSERT_LESS_THAN(100000, esp_timer_get_time() - start);
+    }
+
+    for(size_t i=0; i<4; ++i)
+    {
+        TEST_ASSERT_EQUAL(i < 3 ? i + 1 : 9, at24256.read(0x1F00 + i * AT24C256<>::PAGE_SIZE).value());
+    }
+}
+
+void test_AT24C256_bus()
+{
+    AT24C256 at24256(g_bus_handle, 0x51, { .scl_speed_hz = AT24C256<>::I2C_MASTER_FREQ_HZ_FAST, .write_completion = AT24C256WriteCompletion::deferred });
+
+    // A second chip is optional: its write cycles overlap with the first one's
+    bool second_chip = i2c_master_probe(g_bus_handle, 0x50, 10) == ESP_OK;
+    AT24C256 other(g_bus_handle, second_chip ? 0x50 : 0x51, { .scl_speed_hz = AT24C256<>::I2C_MASTER_FREQ_HZ_FAST, .write_completion = AT24C256WriteCompletion::deferred });
+
+    std::array<uint8_t, 200> data;
+    for(size_t i=0; i<data.size(); ++i)
+        data[i] = 0x3C ^ i;
+
+    std::array<uint8_t, 200> result{};
+    std::array<uint8_t, 200> other_result{};
+    int done = 0;
+
+    auto count = [](bool success, void* user_data) {
+        if(success)
+            ++(*static_cast<int*>(user_data));
+    };
+
+    {
+        AT24C256Bus bus;
+
+        auto first = bus.attach(at24256);
+        TEST_ASSERT_TRUE(first.has_value());
+
+        // Pages 108 to 111, read back in order
+        TEST_ASSERT_TRUE(bus.write_async(*first, 0x1B00, data, count, &done));
+        TEST_ASSERT_TRUE(bus.read_async(*first, 0x1B00, result, count, &done));
+
+        if(second_chip)
+        {
+            auto second = bus.attach(other);
+            TEST_ASSERT_TRUE(second.has_value());
+
+            TEST_ASSERT_TRUE(bus.write_async(*second, 0x1B00, data, count, &done));
+            TEST_ASSERT_TRUE(bus.read_async(*second, 0x1B00, other_result, count, &done));
+        }
+
+        TEST_ASSERT_FALSE(bus.write_async(AT24C256Bus<>::MAX_DEVICES, 0x1B00, data));
+        TEST_ASSERT_FALSE(bus.read_async(*first, 0x7FF0, result));
+
+        TEST_ASSERT_TRUE(bus.wait_idle());
+        TEST_ASSERT_EQUAL(second_chip ? 4 : 2, done);
+        TEST_ASSERT_EQUAL_MEMORY(data.data(), result.data(), data.size());
+
+        if(second_chip)
+            TEST_ASSERT_EQUAL_MEMORY(data.data(), other_result.data(), data.size());
+
+        TEST_ASSERT_TRUE(bus.write_async(*first, 0x1B00, std::span(data).first(10)));
+    }
+
+    // Queued operations are done before destruction
+    TEST_ASSERT_EQUAL(data[9], at24256.read(0x1B09).value());
+}
+
+void count_progress(uint16_t done_pages, uint16_t total_pages, void* user_data)
+{
+    uint16_t& calls = *static_cast<uint16_t*>(user_data);
+
+    calls++;
+    TEST_ASSERT_EQUAL(calls, done_pages);
+    TEST_ASSERT_LESS_OR_EQUAL(total_pages, done_pages);
+}
+
+void test_AT24C256_program_image()
+{
+    AT24C256 at24256(g_bus_handle, 0x51, { .scl_speed_hz = AT24C256<>::I2C_MASTER_FREQ_HZ_FAST, .write_completion = AT24C256WriteCompletion::fixed_delay });
+
+    std::array<uint8_t, 200> image;
+    for(size_t i=0; i<image.size(); ++i)
+        image[i] = i + 1;
+
+    // Pages 92 to 95, ACK polled even with a fixed delay configured
+    uint16_t calls = 0;
+    int64_t start = esp_timer_get_time();
+    TEST_ASSERT_TRUE(at24256.program_image(0x1700, image, false, count_progress, &calls));
+    int64_t duration = esp_timer_get_time() - start;
+
+    TEST_ASSERT_EQUAL(4, calls);
+    TEST_ASSERT_LESS_THAN(4 * 25000, duration);
+
+    std::array<uint8_t, 200> result;
+    TEST_ASSERT_TRUE(at24256.read(0x1700, result.data(), result.size()));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(image.data(), result.data(), image.size());
+
+#if AT24C256_STATS
+    // Nothing left to program
+    at24256.reset_stats();
+    TEST_ASSERT_TRUE(at24256.program_image(0x1700, image, true));
+    TEST_ASSERT_EQUAL(0, at24256.stats().page_cycles);
+#endif
+}
+
+void test_AT24C256_erase()
+{
+    AT24C256 at24256(g_bus_handle, 0x51, { .scl_speed_hz = AT24C256<>::I2C_MASTER_FREQ_HZ_FAST });
+
+    uint16_t calls = 0;
+    int64_t start = esp_timer_get_time();
+    TEST_ASSERT_TRUE(at24256.erase(false, count_progress, &calls));
+    int64_t duration = esp_timer_get_time() - start;
+
+    TEST_ASSERT_EQUAL(AT24C256<>::PAGE_COUNT, calls);
+
+    // tWR (5 ms max) and a 66 bytes transfer at 400 kHz per page
+    TEST_ASSERT_LESS_THAN(AT24C256<>::PAGE_COUNT * 7000, duration);
+
+    TEST_ASSERT_EQUAL(0xFF, *at24256.read(0x0000));
+    TEST_ASSERT_EQUAL(0xFF, *at24256.read(0x4321));
+    TEST_ASSERT_EQUAL(0xFF, *at24256.read(0x7FFF));
+
+    // Already erased: reads only
+    start = esp_timer_get_time();
+    TEST_ASSERT_TRUE(at24256.erase(true));
+    TEST_ASSERT_LESS_THAN(duration, esp_timer_get_time() - start);
+}
+
 void app_main(void)
 {
     esp_log_level_set("*", ESP_LOG_DEBUG);
@@ -237,6 +1380,34 @@ void app_main(void)
     RUN_TEST(test_AT24C256_multi_read_write_big);
     RUN_TEST(test_AT24C256_multi_read_write_edge);
     RUN_TEST(test_AT24C256_read_write_arbitrary_type);
+    RUN_TEST(test_AT24C256_write_completion);
+    RUN_TEST(test_AT24C256_deferred_write);
+    RUN_TEST(test_AT24C256_skip_unchanged);
+    RUN_TEST(test_AT24C256_vectored);
+    RUN_TEST(test_AT24C256_stats);
+    RUN_TEST(test_AT24C256_retry);
+    RUN_TEST(test_AT24C256_checked);
+    RUN_TEST(test_AT24C256_geometry);
+    RUN_TEST(test_AT24C256_scl_speed);
+    RUN_TEST(test_AT24C256_current_address);
+    RUN_TEST(test_AT24C256_page_cache);
+    RUN_TEST(test_AT24C256_async);
+    RUN_TEST(test_AT24C256_shared);
+    RUN_TEST(test_AT24C256_array);
+    RUN_TEST(test_AT24C256_read_ahead);
+    RUN_TEST(test_AT24C256_read_stream);
+    RUN_TEST(test_AT24C256_log);
+    RUN_TEST(test_AT24C256_kv_store);
+    RUN_TEST(test_AT24C256_kv_store_mount);
+    RUN_TEST(test_AT24C256_atomic);
+    RUN_TEST(test_AT24C256_mirror);
+    RUN_TEST(test_AT24C256_write_behind);
+    RUN_TEST(test_AT24C256_write_batch);
+    RUN_TEST(test_AT24C256_bus);
+    RUN_TEST(test_AT24C256_program_image);
+
+    // Last: clears the whole chip
+    RUN_TEST(test_AT24C256_erase);
 
     UNITY_END();
 }